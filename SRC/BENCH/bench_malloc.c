@@ -0,0 +1,289 @@
+// arm_malloc 各分配引擎在碎片化堆上的延迟对比
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "arm_malloc.h"
+
+#define HEAP_SIZE   (16u << 20)
+#define MAX_BLOCKS  (1 << 18)
+#define ITERATIONS  200000
+
+static unsigned char heap[HEAP_SIZE] __attribute__((aligned(16)));
+static void *blocks[MAX_BLOCKS];
+
+// 简单的线性同余随机数，保证各引擎看到相同的请求序列
+static uint32_t rng_state;
+static uint32_t rng_next(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// 碎片块与计时请求都大于快速箱/线程缓存的上限（512 B），也不进入微小对象层，
+// 分配和释放都落到所选引擎的空闲索引上
+#define FRAG_MIN     528
+#define FRAG_RANGE   128
+#define REQUEST_MIN  (FRAG_MIN + FRAG_RANGE)
+#define REQUEST_RANGE 1024
+
+// 用大量较小的块夹杂少量大块填满半个堆，再释放其中一半，
+// 得到成千上万个放不下计时请求的空闲碎片
+static int fragment_heap(void) {
+    int count = 0;
+    size_t used = 0;
+    while (count < MAX_BLOCKS && used < HEAP_SIZE / 2) {
+        size_t size = (count % 64 == 0) ? 4096 + rng_next() % 4096 : FRAG_MIN + rng_next() % FRAG_RANGE;
+        void *p = arm_malloc(size);
+        if (p == NULL) {
+            break;
+        }
+        blocks[count++] = p;
+        used += size + META_SIZE;
+    }
+    for (int i = 0; i < count; i += 2) {
+        arm_free(blocks[i]);
+        blocks[i] = NULL;
+    }
+    return count;
+}
+
+static void run_mode(const char *name, arm_malloc_mode mode) {
+    arm_malloc_init_mode(heap, sizeof(heap), mode);
+    rng_state = 12345;
+    int count = fragment_heap();
+
+    // 随机挑选槽位：已占用则释放，空闲则分配，保持堆处于碎片化状态
+    uint64_t total = 0, worst = 0;
+    int failed = 0;
+    for (int i = 0; i < ITERATIONS; i++) {
+        int slot = (int)(rng_next() % (uint32_t)count);
+        size_t size = REQUEST_MIN + rng_next() % REQUEST_RANGE;
+
+        uint64_t start = now_ns();
+        if (blocks[slot] != NULL) {
+            arm_free(blocks[slot]);
+            blocks[slot] = NULL;
+        } else {
+            blocks[slot] = arm_malloc(size);
+            if (blocks[slot] == NULL) {
+                failed++;
+            }
+        }
+        uint64_t elapsed = now_ns() - start;
+
+        total += elapsed;
+        if (elapsed > worst) {
+            worst = elapsed;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        arm_free(blocks[i]);
+    }
+
+    printf("%-12s %8d blocks  avg %8.1f ns  max %8llu ns  failed %d\n",
+           name, count, (double)total / ITERATIONS, (unsigned long long)worst, failed);
+}
+
+// 较大块（超出小块缓存）的分配/释放延迟分开统计：在碎片化堆上另外维持
+// LARGE_SLOTS 个块，大小取自少数几种常见尺寸，便于观察延迟合并队列的复用效果
+#define LARGE_SLOTS 1024
+
+static void run_large(void) {
+    static const size_t sizes[] = {768, 1536, 2048, 4096};
+    static void *large[LARGE_SLOTS];
+    uint64_t alloc_total = 0, alloc_worst = 0, free_total = 0, free_worst = 0;
+    int allocs = 0, frees = 0, failed = 0;
+
+    arm_malloc_init(heap, sizeof(heap));
+    rng_state = 12345;
+    fragment_heap();
+    for (int i = 0; i < ITERATIONS; i++) {
+        int slot = (int)(rng_next() % LARGE_SLOTS);
+        size_t size = sizes[rng_next() % 4];
+
+        uint64_t start = now_ns();
+        if (large[slot] != NULL) {
+            arm_free(large[slot]);
+            large[slot] = NULL;
+            uint64_t elapsed = now_ns() - start;
+            free_total += elapsed;
+            free_worst = elapsed > free_worst ? elapsed : free_worst;
+            frees++;
+        } else {
+            large[slot] = arm_malloc(size);
+            uint64_t elapsed = now_ns() - start;
+            alloc_total += elapsed;
+            alloc_worst = elapsed > alloc_worst ? elapsed : alloc_worst;
+            allocs++;
+            failed += large[slot] == NULL;
+        }
+    }
+    for (int i = 0; i < LARGE_SLOTS; i++) {
+        arm_free(large[i]);
+        large[i] = NULL;
+    }
+
+    printf("malloc avg %6.1f ns  max %8llu ns   free avg %6.1f ns  max %8llu ns  failed %d\n",
+           (double)alloc_total / allocs, (unsigned long long)alloc_worst,
+           (double)free_total / frees, (unsigned long long)free_worst, failed);
+}
+
+// 成组分配/释放 BATCH_COUNT 个同样大小的块：逐个调用与批量接口对比
+#define BATCH_COUNT   64
+#define BATCH_ROUNDS  20000
+
+static void run_batch(size_t size) {
+    void *group[BATCH_COUNT];
+    uint64_t single = 0, batch = 0;
+
+    arm_malloc_init(heap, sizeof(heap));
+    rng_state = 12345;
+    fragment_heap();
+
+    for (int round = 0; round < BATCH_ROUNDS; round++) {
+        uint64_t start = now_ns();
+        for (int i = 0; i < BATCH_COUNT; i++) {
+            group[i] = arm_malloc(size);
+        }
+        for (int i = 0; i < BATCH_COUNT; i++) {
+            arm_free(group[i]);
+        }
+        single += now_ns() - start;
+
+        start = now_ns();
+        arm_malloc_batch(size, BATCH_COUNT, group);
+        arm_free_batch(group, BATCH_COUNT);
+        batch += now_ns() - start;
+    }
+
+    printf("%5u B x %d  逐个 %8.1f ns  批量 %8.1f ns\n", (unsigned)size, BATCH_COUNT,
+           (double)single / BATCH_ROUNDS, (double)batch / BATCH_ROUNDS);
+}
+
+// 小对象内存效率：用同一大小的请求填满堆，调用者得到的字节占堆的比例
+static void run_density(size_t size) {
+    arm_malloc_stats_t stats;
+    size_t count = 0;
+
+    arm_malloc_init(heap, sizeof(heap));
+    while (arm_malloc(size) != NULL) {
+        count++;
+    }
+    arm_malloc_get_stats(&stats);
+
+    printf("%5u B  %9lu 个  效率 %5.1f%%\n", (unsigned)size, (unsigned long)count,
+           100.0 * (double)(count * size) / (double)stats.heap_size);
+}
+
+// 大块 calloc：在已清零的新堆上连续分配 CALLOC_COUNT 个块，
+// 比较声明区域已清零（跳过 memset）与未声明两种情况
+#define CALLOC_COUNT 8
+
+static void run_calloc(size_t size) {
+    uint64_t elapsed[2];
+
+    for (int zeroed = 0; zeroed < 2; zeroed++) {
+        memset(heap, 0, sizeof(heap));
+        arm_malloc_init(heap, sizeof(heap));
+        if (zeroed) {
+            heap_assume_zeroed(arm_malloc_default_heap());
+        }
+
+        uint64_t start = now_ns();
+        for (int i = 0; i < CALLOC_COUNT; i++) {
+            blocks[i] = arm_calloc(1, size);
+        }
+        elapsed[zeroed] = now_ns() - start;
+    }
+
+    printf("%5u KiB x %d  清零 %9.1f us  跳过 %9.1f us\n", (unsigned)(size >> 10), CALLOC_COUNT,
+           elapsed[0] / 1e3 / CALLOC_COUNT, elapsed[1] / 1e3 / CALLOC_COUNT);
+}
+
+#if ARM_MALLOC_HANDLES
+// 句柄整理：用句柄块填满半个堆再释放一半，反复以 budget 为时间片调用整理，
+// 直到一整轮不再搬移，记录单次调用的最长耗时与整理前后的最大空闲块
+static void run_compact(size_t budget) {
+    static arm_handle_t handles[MAX_BLOCKS];
+    arm_malloc_stats_t before, after;
+    int count = 0;
+
+    arm_malloc_init(heap, sizeof(heap));
+    rng_state = 12345;
+    while (count < MAX_BLOCKS) {
+        handles[count] = hmalloc(64 + rng_next() % 1024);
+        if (handles[count] == 0) {
+            break;
+        }
+        count++;
+    }
+    for (int i = 0; i < count; i += 2) {
+        hfree(handles[i]);
+    }
+    arm_malloc_get_stats(&before);
+
+    // 每次调用至少访问 budget / META_SIZE 个块，连续空转超过一整轮即整理完毕
+    unsigned long idle_limit = (unsigned long)count * META_SIZE / budget + 2;
+    uint64_t total = 0, worst = 0;
+    unsigned long calls = 0, idle = 0;
+    while (idle < idle_limit) {
+        uint64_t start = now_ns();
+        size_t moved = arm_malloc_compact(budget);
+        uint64_t elapsed = now_ns() - start;
+        total += elapsed;
+        worst = elapsed > worst ? elapsed : worst;
+        calls++;
+        idle = moved == 0 ? idle + 1 : 0;
+    }
+    arm_malloc_get_stats(&after);
+
+    printf("%6u B  %8lu 次  总计 %7.2f ms  单次最长 %7.1f us  最大空闲块 %5.2f -> %5.2f MiB\n",
+           (unsigned)budget, calls, total / 1e6, worst / 1e3,
+           before.largest_free_block / 1048576.0, after.largest_free_block / 1048576.0);
+}
+#endif
+
+int main(void) {
+    // 关闭线程缓存，直接比较各引擎本身
+    arm_malloc_tcache_enable(0);
+
+    printf("malloc/free 单次延迟（%d 次，碎片化堆 %u MiB）\n", ITERATIONS, HEAP_SIZE >> 20);
+    run_mode("first-fit", ARM_MALLOC_FIRST_FIT);
+    run_mode("segregated", ARM_MALLOC_SEGREGATED);
+    run_mode("tlsf", ARM_MALLOC_TLSF);
+
+    printf("\n较大块延迟（TLSF，碎片化堆，延迟队列 %d 项）\n", ARM_MALLOC_DEFER_QUEUE);
+    run_large();
+
+    printf("\n成组分配再释放（TLSF，碎片化堆）\n");
+    run_batch(64);
+    run_batch(256);
+    run_batch(1500);
+
+    printf("\n小对象内存效率（块头 %u 字节，借用 %u 字节）\n",
+           (unsigned)META_SIZE, (unsigned)HEADER_OVERLAP);
+    run_density(16);
+    run_density(24);
+    run_density(40);
+    run_density(64);
+    run_density(128);
+
+    printf("\n大块 calloc 单次耗时（新堆）\n");
+    run_calloc(64 << 10);
+    run_calloc(1 << 20);
+
+#if ARM_MALLOC_HANDLES
+    printf("\n句柄块增量整理（时间片预算）\n");
+    run_compact(4096);
+    run_compact(65536);
+#endif
+    return 0;
+}
@@ -0,0 +1,368 @@
+// my_memory 中各 memcpy/memset 实现的吞吐量扫描与分派阈值标定
+// 用法：bench_mem [阈值头文件] [CSV 文件]
+// 按 1 B~64 MiB、多种源/目标对齐、热/冷缓存逐个测量变体表中的实现，
+// 在标准输出打印表格，CSV 中保存全部数据；给出头文件路径时写入测得的流式阈值
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "my_memory.h"
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+#define MAX_SIZE_SHIFT 26            // 最大 64 MiB
+#define SIZE_COUNT     (MAX_SIZE_SHIFT + 1)
+#define CYCLE_TABLE_MAX 4096         // 每次调用周期数的表格只列到 4 KiB
+#define MAX_VARIANTS   16
+#define ALIGN_MAX      4
+#define BATCHES        5
+#define BATCH_NS       1000000u      // 每批至少 1 ms，取各批中最快的一批
+#define SLOT_ALIGN     4096
+#define POOL_MIN       (16u << 20)
+#define POOL_MAX       (256u << 20)
+
+enum { OP_COPY, OP_SET, OP_COUNT };
+enum { CACHE_HOT, CACHE_COLD, CACHE_COUNT };
+
+typedef struct {
+    unsigned dst;
+    unsigned src;
+} align_pair;
+
+static const align_pair copy_aligns[] = { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 3, 7 } };
+static const align_pair set_aligns[] = { { 0, 0 }, { 1, 0 }, { 3, 0 } };
+static const align_pair *const op_aligns[OP_COUNT] = { copy_aligns, set_aligns };
+static const size_t op_align_count[OP_COUNT] = {
+    sizeof(copy_aligns) / sizeof(copy_aligns[0]),
+    sizeof(set_aligns) / sizeof(set_aligns[0]),
+};
+
+static const char *const op_names[OP_COUNT] = { "memcpy", "memset" };
+static const char *const cache_names[CACHE_COUNT] = { "hot", "cold" };
+
+// 被测实现：复制与填充共用同一套计时代码，二者只设其一
+typedef struct {
+    const char *name;
+    pbs_copy_fn copy;
+    pbs_set_fn set;
+} kernel_t;
+
+static kernel_t kernels[OP_COUNT][MAX_VARIANTS];
+static size_t kernel_count[OP_COUNT];
+
+// 每次调用的纳秒数
+static double results[OP_COUNT][MAX_VARIANTS][SIZE_COUNT][ALIGN_MAX][CACHE_COUNT];
+
+// 冷缓存模式在两个大缓冲池中轮换槽位，每个槽位再次被访问前已被其余槽位挤出缓存
+static unsigned char *src_pool;
+static unsigned char *dst_pool;
+static size_t pool_size;
+static double cycles_per_ns;  // 0 表示无法换算
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// 周期换算：x86-64 用 TSC 频率；AArch64 用户态读不到周期计数器，
+// 用单周期延迟的依赖加法链估算主频
+static double measure_cycles_per_ns(void) {
+#if defined(__x86_64__)
+    uint64_t start = now_ns();
+    uint64_t tsc = __rdtsc();
+    while (now_ns() - start < 50000000u) {
+    }
+    return (double)(__rdtsc() - tsc) / (double)(now_ns() - start);
+#elif defined(__aarch64__)
+    const long loops = 10000000;
+    uint64_t x = 0;
+    uint64_t start = now_ns();
+    for (long i = 0; i < loops; i++) {
+        __asm__ volatile("add %0, %0, #1\n\tadd %0, %0, #1\n\tadd %0, %0, #1\n\tadd %0, %0, #1\n\t"
+                         "add %0, %0, #1\n\tadd %0, %0, #1\n\tadd %0, %0, #1\n\tadd %0, %0, #1"
+                         : "+r"(x));
+    }
+    return (double)loops * 8 / (double)(now_ns() - start);
+#else
+    return 0;
+#endif
+}
+
+static void collect_kernels(unsigned features) {
+    for (size_t i = 0; i < pbs_memcpy_variant_count && kernel_count[OP_COPY] < MAX_VARIANTS; i++) {
+        const pbs_copy_variant *v = &pbs_memcpy_variants[i];
+        if ((v->requires & features) == v->requires) {
+            kernel_t *k = &kernels[OP_COPY][kernel_count[OP_COPY]++];
+            k->name = v->name;
+            k->copy = v->fn;
+        }
+    }
+    for (size_t i = 0; i < pbs_memset_variant_count && kernel_count[OP_SET] < MAX_VARIANTS; i++) {
+        const pbs_set_variant *v = &pbs_memset_variants[i];
+        if ((v->requires & features) == v->requires) {
+            kernel_t *k = &kernels[OP_SET][kernel_count[OP_SET]++];
+            k->name = v->name;
+            k->set = v->fn;
+        }
+    }
+}
+
+static int find_kernel(int op, pbs_copy_fn copy, pbs_set_fn set) {
+    for (size_t i = 0; i < kernel_count[op]; i++) {
+        if ((copy && kernels[op][i].copy == copy) || (set && kernels[op][i].set == set)) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static void run_kernel(const kernel_t *k, size_t offset, align_pair a, size_t n) {
+    if (k->copy) {
+        k->copy(dst_pool + offset + a.dst, src_pool + offset + a.src, n);
+    } else {
+        k->set(dst_pool + offset + a.dst, 0, n);
+    }
+}
+
+// 返回每次调用的纳秒数：先把每批的调用次数加倍到不少于 BATCH_NS，再取 BATCHES 批中最快的
+static double measure(const kernel_t *k, size_t n, align_pair a, int cache) {
+    size_t stride = (n + 64 + SLOT_ALIGN - 1) / SLOT_ALIGN * SLOT_ALIGN;
+    size_t slots = cache == CACHE_HOT ? 1 : pool_size / stride;
+    size_t slot = 0;
+
+    for (size_t i = 0; i < slots; i++) {
+        run_kernel(k, i * stride, a, n);
+    }
+
+    size_t reps = 1;
+    uint64_t elapsed;
+    for (;;) {
+        uint64_t start = now_ns();
+        for (size_t i = 0; i < reps; i++) {
+            run_kernel(k, slot * stride, a, n);
+            if (++slot == slots) {
+                slot = 0;
+            }
+        }
+        elapsed = now_ns() - start;
+        if (elapsed >= BATCH_NS || reps >= (1u << 24)) {
+            break;
+        }
+        reps *= 2;
+    }
+
+    double best = (double)elapsed / (double)reps;
+    for (int b = 1; b < BATCHES; b++) {
+        uint64_t start = now_ns();
+        for (size_t i = 0; i < reps; i++) {
+            run_kernel(k, slot * stride, a, n);
+            if (++slot == slots) {
+                slot = 0;
+            }
+        }
+        double per_call = (double)(now_ns() - start) / (double)reps;
+        if (per_call < best) {
+            best = per_call;
+        }
+    }
+    return best;
+}
+
+static void format_size(char *buf, size_t len, size_t n) {
+    if (n >= (1u << 20)) {
+        snprintf(buf, len, "%zuM", n >> 20);
+    } else if (n >= (1u << 10)) {
+        snprintf(buf, len, "%zuK", n >> 10);
+    } else {
+        snprintf(buf, len, "%zuB", n);
+    }
+}
+
+// 所有对齐方式合计的纳秒数，用于表格与阈值比较
+static double total_ns(int op, size_t k, int s, int cache) {
+    double total = 0;
+    for (size_t a = 0; a < op_align_count[op]; a++) {
+        total += results[op][k][s][a][cache];
+    }
+    return total;
+}
+
+static void print_table(int op, int cache, int cycles) {
+    printf("\n%s %s，%s（各对齐方式平均）\n", op_names[op], cache_names[cache],
+           cycles ? "每次调用周期数" : "GB/s");
+    printf("%-6s", "size");
+    for (size_t k = 0; k < kernel_count[op]; k++) {
+        printf(" %12s", kernels[op][k].name);
+    }
+    printf("\n");
+
+    for (int s = 0; s < SIZE_COUNT; s++) {
+        size_t n = (size_t)1 << s;
+        if (cycles && n > CYCLE_TABLE_MAX) {
+            break;
+        }
+        char label[16];
+        format_size(label, sizeof(label), n);
+        printf("%-6s", label);
+        for (size_t k = 0; k < kernel_count[op]; k++) {
+            double ns = total_ns(op, k, s, cache) / (double)op_align_count[op];
+            printf(" %12.2f", cycles ? ns * cycles_per_ns : (double)n / ns);
+        }
+        printf("\n");
+    }
+}
+
+static void write_csv(const char *path) {
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL) {
+        perror(path);
+        return;
+    }
+    fprintf(fp, "op,variant,size,dst_align,src_align,cache,ns_per_call,cycles_per_call,gb_per_s\n");
+    for (int op = 0; op < OP_COUNT; op++) {
+        for (size_t k = 0; k < kernel_count[op]; k++) {
+            for (int s = 0; s < SIZE_COUNT; s++) {
+                size_t n = (size_t)1 << s;
+                for (size_t a = 0; a < op_align_count[op]; a++) {
+                    for (int c = 0; c < CACHE_COUNT; c++) {
+                        double ns = results[op][k][s][a][c];
+                        fprintf(fp, "%s,%s,%zu,%u,%u,%s,%.2f,%.1f,%.3f\n", op_names[op],
+                                kernels[op][k].name, n, op_aligns[op][a].dst, op_aligns[op][a].src,
+                                cache_names[c], ns, ns * cycles_per_ns, (double)n / ns);
+                    }
+                }
+            }
+        }
+    }
+    fclose(fp);
+    printf("\nCSV 已写入 %s\n", path);
+}
+
+// 流式实现从某个尺寸起在所有更大的尺寸上都不慢于中等尺寸实现时，该尺寸即为交叉点。
+// 用热缓存的数据比较：目标数据仍在缓存中时绕过缓存会损失后续的命中，热缓存下找到的交叉点偏保守。
+// 返回 0 表示扫描范围内流式实现没有持续领先
+static size_t find_crossover(int op, int medium, int large) {
+    if (medium < 0 || large < 0 || medium == large) {
+        return 0;
+    }
+    size_t crossover = 0;
+    for (int s = SIZE_COUNT - 1; s >= 0; s--) {
+        if (total_ns(op, (size_t)large, s, CACHE_HOT) > total_ns(op, (size_t)medium, s, CACHE_HOT)) {
+            break;
+        }
+        crossover = (size_t)1 << s;
+    }
+    return crossover;
+}
+
+static void write_threshold(FILE *fp, const char *macro, int op, int medium, int large, size_t crossover) {
+    const char *medium_name = medium >= 0 ? kernels[op][medium].name : "?";
+    const char *large_name = large >= 0 ? kernels[op][large].name : "?";
+    if (crossover == 0) {
+        fprintf(fp, "// %s: %s / %s，64 MiB 以内流式实现没有持续领先，沿用按缓存大小估计的阈值\n",
+                op_names[op], medium_name, large_name);
+        return;
+    }
+    fprintf(fp, "// %s: %s / %s\n", op_names[op], medium_name, large_name);
+    fprintf(fp, "#ifndef %s\n#define %s %zu\n#endif\n", macro, macro, crossover);
+}
+
+static void write_header(const char *path, const pbs_memory_ops *ops, size_t copy_crossover,
+                         size_t set_crossover) {
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL) {
+        perror(path);
+        return;
+    }
+    fprintf(fp, "// 由 make bench-mem 生成，请勿手工修改；make clean 时删除\n");
+    fprintf(fp, "// CPU 特性 0x%x，检测到的缓存 %zu KiB\n", ops->features, ops->cache_size >> 10);
+    fprintf(fp, "#ifndef PBS_MEMORY_TUNED_H\n#define PBS_MEMORY_TUNED_H\n\n");
+    write_threshold(fp, "PBS_MEMCPY_LARGE", OP_COPY, find_kernel(OP_COPY, ops->copy_medium, NULL),
+                    find_kernel(OP_COPY, ops->copy_large, NULL), copy_crossover);
+    write_threshold(fp, "PBS_MEMSET_LARGE", OP_SET, find_kernel(OP_SET, NULL, ops->set_medium),
+                    find_kernel(OP_SET, NULL, ops->set_large), set_crossover);
+    fprintf(fp, "\n#endif // PBS_MEMORY_TUNED_H\n");
+    fclose(fp);
+    printf("阈值已写入 %s，重新 make 后分派使用新阈值\n", path);
+}
+
+int main(int argc, char **argv) {
+    const char *header_path = argc > 1 ? argv[1] : NULL;
+    const char *csv_path = argc > 2 ? argv[2] : NULL;
+    const pbs_memory_ops *ops = pbs_memory_ops_get();
+
+    collect_kernels(ops->features);
+    cycles_per_ns = measure_cycles_per_ns();
+
+    // 缓冲池取末级缓存的两倍，限制在 [POOL_MIN, POOL_MAX]，分配失败时减半
+    pool_size = ops->cache_size * 2;
+    if (pool_size < POOL_MIN) {
+        pool_size = POOL_MIN;
+    }
+    if (pool_size > POOL_MAX) {
+        pool_size = POOL_MAX;
+    }
+    size_t min_pool = ((size_t)1 << MAX_SIZE_SHIFT) + SLOT_ALIGN * 2;
+    for (;;) {
+        void *src = NULL, *dst = NULL;
+        if (posix_memalign(&src, SLOT_ALIGN, pool_size) == 0 &&
+            posix_memalign(&dst, SLOT_ALIGN, pool_size) == 0) {
+            src_pool = src;
+            dst_pool = dst;
+            break;
+        }
+        free(src);
+        if (pool_size / 2 < min_pool) {
+            fprintf(stderr, "无法分配 %zu MiB 的缓冲池\n", pool_size >> 20);
+            return 1;
+        }
+        pool_size /= 2;
+    }
+    memset(src_pool, 0xA5, pool_size);
+    memset(dst_pool, 0, pool_size);
+
+    printf("CPU 特性 0x%x，缓存 %zu KiB，缓冲池 2 x %zu MiB，%.2f 周期/ns\n", ops->features,
+           ops->cache_size >> 10, pool_size >> 20, cycles_per_ns);
+    printf("当前分派：memcpy %zu 字节起走流式实现，memset %zu 字节起\n", ops->copy_large_min,
+           ops->set_large_min);
+
+    for (int op = 0; op < OP_COUNT; op++) {
+        for (size_t k = 0; k < kernel_count[op]; k++) {
+            fprintf(stderr, "测量 %s %s...\n", op_names[op], kernels[op][k].name);
+            for (int s = 0; s < SIZE_COUNT; s++) {
+                for (size_t a = 0; a < op_align_count[op]; a++) {
+                    for (int c = 0; c < CACHE_COUNT; c++) {
+                        results[op][k][s][a][c] =
+                            measure(&kernels[op][k], (size_t)1 << s, op_aligns[op][a], c);
+                    }
+                }
+            }
+        }
+        print_table(op, CACHE_HOT, 0);
+        print_table(op, CACHE_COLD, 0);
+        if (cycles_per_ns > 0) {
+            print_table(op, CACHE_HOT, 1);
+        }
+    }
+
+    size_t copy_crossover = find_crossover(OP_COPY, find_kernel(OP_COPY, ops->copy_medium, NULL),
+                                           find_kernel(OP_COPY, ops->copy_large, NULL));
+    size_t set_crossover = find_crossover(OP_SET, find_kernel(OP_SET, NULL, ops->set_medium),
+                                          find_kernel(OP_SET, NULL, ops->set_large));
+    printf("\n交叉点：memcpy %zu，memset %zu（0 表示 64 MiB 以内没有）\n", copy_crossover, set_crossover);
+
+    if (csv_path != NULL) {
+        write_csv(csv_path);
+    }
+    if (header_path != NULL) {
+        write_header(header_path, ops, copy_crossover, set_crossover);
+    }
+
+    free(src_pool);
+    free(dst_pool);
+    return 0;
+}
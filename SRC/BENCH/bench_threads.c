@@ -0,0 +1,86 @@
+// arm_malloc 多线程扩展性测试：1..N 个线程并发执行小块 malloc/free
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "arm_malloc.h"
+
+#define HEAP_SIZE       (64u << 20)
+#define SLOTS_PER_THREAD 256
+#define OPS_PER_THREAD  200000
+#define MAX_THREADS     64
+
+static unsigned char heap[HEAP_SIZE] __attribute__((aligned(16)));
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+typedef struct {
+    uint32_t seed;
+    size_t fixed_size;  // 非 0 时该线程只分配这一种大小
+} worker_arg;
+
+// 每个线程维护自己的工作集，随机释放或分配 16..256 字节的块
+static void *worker(void *arg) {
+    const worker_arg *wa = (const worker_arg *)arg;
+    uint32_t rng = wa->seed * 2654435761u + 1;
+    void *slots[SLOTS_PER_THREAD] = {NULL};
+
+    for (int i = 0; i < OPS_PER_THREAD; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        int slot = (int)((rng >> 8) % SLOTS_PER_THREAD);
+        if (slots[slot] != NULL) {
+            arm_free(slots[slot]);
+            slots[slot] = NULL;
+        } else {
+            slots[slot] = arm_malloc(wa->fixed_size ? wa->fixed_size : 16 + (rng >> 20) % 241);
+        }
+    }
+
+    for (int i = 0; i < SLOTS_PER_THREAD; i++) {
+        arm_free(slots[i]);
+    }
+    return NULL;
+}
+
+// 返回全部线程的总吞吐量（ops/s）；distinct 为真时每个线程使用不同的大小类
+static double run(int threads, int distinct) {
+    pthread_t tids[MAX_THREADS];
+    worker_arg args[MAX_THREADS];
+    uint64_t start = now_ns();
+    for (int i = 0; i < threads; i++) {
+        args[i].seed = (uint32_t)(i + 1);
+        args[i].fixed_size = distinct ? (size_t)(16 * (i % 32 + 1)) : 0;
+        pthread_create(&tids[i], NULL, worker, &args[i]);
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    double seconds = (double)(now_ns() - start) / 1e9;
+    return (double)threads * OPS_PER_THREAD / seconds;
+}
+
+int main(int argc, char **argv) {
+    int max_threads = argc > 1 ? atoi(argv[1]) : 8;
+    if (max_threads < 1 || max_threads > MAX_THREADS) {
+        max_threads = 8;
+    }
+
+    arm_malloc_init(heap, sizeof(heap));
+    printf("吞吐量 (Mops/s)\n");
+    printf("线程数  无缓存/混合大小  无缓存/各线程不同大小  线程缓存/混合大小\n");
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        arm_malloc_tcache_enable(0);
+        double mixed = run(threads, 0);
+        double distinct = run(threads, 1);
+        arm_malloc_tcache_enable(1);
+        double cached = run(threads, 0);
+        printf("%6d  %15.2f  %21.2f  %17.2f\n", threads, mixed / 1e6, distinct / 1e6, cached / 1e6);
+    }
+    return 0;
+}
@@ -0,0 +1,334 @@
+// 分配器轨迹回放基准：同一份 malloc/free/realloc 序列分别交给 arm_malloc
+// 和主机 glibc malloc 执行，输出吞吐量、单次延迟分位数与已占用字节的峰值。
+//
+// 用法：bench_trace [轨迹文件...]
+// 不带参数时回放内置的合成负载。轨迹文件为文本格式，每行一个操作，
+// # 开头的行为注释：
+//   a <id> <size>    分配 size 字节，结果记为 id
+//   f <id>           释放 id
+//   r <id> <size>    把 id 重新分配为 size 字节
+#define _POSIX_C_SOURCE 199309L
+#include <malloc.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "arm_malloc.h"
+
+#define HEAP_SIZE   (64u << 20)
+#define MAX_IDS     (1u << 16)
+#define MAX_OPS     (1u << 21)
+
+static unsigned char heap[HEAP_SIZE] __attribute__((aligned(16)));
+
+typedef struct {
+    char type;      // 'a' / 'f' / 'r'
+    uint32_t id;
+    uint32_t size;
+} trace_op;
+
+typedef struct {
+    const char *name;
+    trace_op *ops;
+    size_t count;
+} trace_t;
+
+static trace_op op_buffer[MAX_OPS];
+static uint32_t latency[MAX_OPS];
+static void *slots[MAX_IDS];
+
+// ---------------------------------------------------------------------------
+// 被测分配器
+// ---------------------------------------------------------------------------
+typedef struct {
+    const char *name;
+    void *(*malloc_fn)(size_t);
+    void (*free_fn)(void *);
+    void *(*realloc_fn)(void *, size_t);
+    void (*reset)(void);
+    size_t (*peak)(void);
+} allocator_t;
+
+static void arm_reset(void) {
+    arm_malloc_init(heap, sizeof(heap));
+}
+
+static size_t arm_peak(void) {
+    arm_malloc_stats_t stats;
+    arm_malloc_get_stats(&stats);
+    return stats.peak_heap_used;
+}
+
+// 两个分配器比较同一指标：已分配块占用的字节（含块头）的峰值，不含空闲块与从系统取得但未用的内存。
+// arm_malloc 为 peak_heap_used；glibc 定期采样 mallinfo2 的 uordblks（arena 中的已分配块）
+// 加 hblkhd（mmap 分配的块），是近似值
+static size_t glibc_peak_bytes = 0;
+
+static void glibc_reset(void) {
+    malloc_trim(0);
+    glibc_peak_bytes = 0;
+}
+
+static void glibc_sample(void) {
+    struct mallinfo2 info = mallinfo2();
+    size_t used = info.uordblks + info.hblkhd;
+    if (used > glibc_peak_bytes) {
+        glibc_peak_bytes = used;
+    }
+}
+
+static size_t glibc_peak(void) {
+    glibc_sample();
+    return glibc_peak_bytes;
+}
+
+static const allocator_t allocators[] = {
+    { "arm_malloc", arm_malloc, arm_free, arm_realloc, arm_reset, arm_peak },
+    { "glibc",      malloc,     free,     realloc,     glibc_reset, glibc_peak },
+};
+
+// ---------------------------------------------------------------------------
+// 合成负载
+// ---------------------------------------------------------------------------
+static uint32_t rng_state;
+
+static uint32_t rng_next(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static double rng_unit(void) {
+    return (rng_next() + 1.0) / (double)(1u << 24);
+}
+
+static size_t push_op(size_t n, char type, uint32_t id, uint32_t size) {
+    op_buffer[n].type = type;
+    op_buffer[n].id = id;
+    op_buffer[n].size = size;
+    return n + 1;
+}
+
+// 生产者/消费者：消息按 FIFO 顺序生成和释放，队列深度固定
+static trace_t gen_producer_consumer(void) {
+    const uint32_t depth = 1024;
+    size_t n = 0;
+    rng_state = 1;
+    for (uint32_t i = 0; n + 2 <= 1000000; i++) {
+        n = push_op(n, 'a', i % MAX_IDS, 64 + rng_next() % 1985);
+        if (i >= depth) {
+            n = push_op(n, 'f', (i - depth) % MAX_IDS, 0);
+        }
+    }
+    trace_t t = { "producer-consumer", op_buffer, n };
+    return t;
+}
+
+// 幂律大小：多数请求很小，少数很大；随机释放和 realloc
+static trace_t gen_power_law(void) {
+    const uint32_t live_ids = 8192;
+    size_t n = 0;
+    uint8_t live[8192] = {0};
+    rng_state = 2;
+    while (n < 1000000) {
+        uint32_t id = rng_next() % live_ids;
+        uint32_t size = (uint32_t)(16.0 / pow(rng_unit(), 1.0 / 1.2));
+        if (size > 65536) {
+            size = 65536;
+        }
+        if (!live[id]) {
+            n = push_op(n, 'a', id, size);
+            live[id] = 1;
+        } else if (rng_next() % 8 == 0) {
+            n = push_op(n, 'r', id, size);
+        } else {
+            n = push_op(n, 'f', id, 0);
+            live[id] = 0;
+        }
+    }
+    trace_t t = { "power-law", op_buffer, n };
+    return t;
+}
+
+// 长寿命碎片：每轮交替分配长寿命小对象和短寿命中等对象，
+// 释放短寿命对象后再申请更大的块，长寿命对象把空闲空间切碎
+static trace_t gen_long_lived(void) {
+    size_t n = 0;
+    uint32_t next_long = 0;
+    rng_state = 3;
+    for (int round = 0; round < 200 && n + 1024 < MAX_OPS; round++) {
+        uint32_t base = 32768;
+        for (uint32_t i = 0; i < 256; i++) {
+            n = push_op(n, 'a', next_long++ % 32768, 16 + rng_next() % 48);
+            n = push_op(n, 'a', base + i, 256 + rng_next() % 768);
+        }
+        for (uint32_t i = 0; i < 256; i++) {
+            n = push_op(n, 'f', base + i, 0);
+        }
+        for (uint32_t i = 0; i < 64; i++) {
+            n = push_op(n, 'a', base + 256 + i, 2048 + rng_next() % 4096);
+        }
+        for (uint32_t i = 0; i < 64; i++) {
+            n = push_op(n, 'f', base + 256 + i, 0);
+        }
+        // 长寿命对象偶尔成批死亡
+        if (round % 50 == 49) {
+            for (uint32_t i = 0; i < next_long && i < 32768; i += 2) {
+                n = push_op(n, 'f', i, 0);
+            }
+        }
+    }
+    trace_t t = { "long-lived", op_buffer, n };
+    return t;
+}
+
+// 读取文本轨迹文件
+static int load_trace(const char *path, trace_t *t) {
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        printf("无法打开轨迹文件 %s\n", path);
+        return 0;
+    }
+
+    char line[128];
+    size_t n = 0;
+    while (n < MAX_OPS && fgets(line, sizeof(line), fp) != NULL) {
+        char type;
+        unsigned id, size = 0;
+        if (line[0] == '#' || sscanf(line, " %c %u %u", &type, &id, &size) < 2) {
+            continue;
+        }
+        if ((type != 'a' && type != 'f' && type != 'r') || id >= MAX_IDS) {
+            continue;
+        }
+        n = push_op(n, type, id, size);
+    }
+    fclose(fp);
+
+    t->name = path;
+    t->ops = op_buffer;
+    t->count = n;
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// 回放与统计
+// ---------------------------------------------------------------------------
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// 计时器本身的开销，从每次测量中扣除
+static uint64_t timer_overhead(void) {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 1000; i++) {
+        uint64_t start = now_ns();
+        uint64_t elapsed = now_ns() - start;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void replay(const allocator_t *alloc, const trace_t *t, uint64_t overhead) {
+    memset(slots, 0, sizeof(slots));
+    alloc->reset();
+
+    size_t timed = 0;
+    uint64_t total = 0;
+    for (size_t i = 0; i < t->count; i++) {
+        const trace_op *op = &t->ops[i];
+        void **slot = &slots[op->id];
+        uint64_t start, elapsed;
+
+        switch (op->type) {
+        case 'a':
+            if (*slot != NULL) {
+                alloc->free_fn(*slot);
+            }
+            start = now_ns();
+            *slot = alloc->malloc_fn(op->size);
+            elapsed = now_ns() - start;
+            break;
+        case 'r': {
+            start = now_ns();
+            void *p = alloc->realloc_fn(*slot, op->size);
+            elapsed = now_ns() - start;
+            if (p != NULL) {
+                *slot = p;
+            }
+            break;
+        }
+        default:
+            start = now_ns();
+            alloc->free_fn(*slot);
+            elapsed = now_ns() - start;
+            *slot = NULL;
+            break;
+        }
+
+        elapsed = elapsed > overhead ? elapsed - overhead : 0;
+        latency[timed++] = elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed;
+        total += elapsed;
+
+        if (alloc->reset == glibc_reset && (i & 1023) == 0) {
+            glibc_sample();
+        }
+    }
+
+    size_t peak = alloc->peak();
+    for (size_t i = 0; i < MAX_IDS; i++) {
+        if (slots[i] != NULL) {
+            alloc->free_fn(slots[i]);
+        }
+    }
+
+    if (timed == 0) {
+        printf("  %-10s 轨迹中没有有效操作\n", alloc->name);
+        return;
+    }
+
+    qsort(latency, timed, sizeof(latency[0]), cmp_u32);
+    printf("  %-10s %10.2f Mops/s  p50 %5u ns  p99 %6u ns  max %8u ns  peak used %7.2f MiB\n",
+           alloc->name, total > 0 ? timed * 1e3 / (double)total : 0.0,
+           latency[timed / 2], latency[timed * 99 / 100], latency[timed - 1],
+           peak / 1048576.0);
+}
+
+static void run_trace(const trace_t *t, uint64_t overhead) {
+    printf("%s（%lu 次操作）\n", t->name, (unsigned long)t->count);
+    for (size_t i = 0; i < sizeof(allocators) / sizeof(allocators[0]); i++) {
+        replay(&allocators[i], t, overhead);
+    }
+}
+
+int main(int argc, char **argv) {
+    uint64_t overhead = timer_overhead();
+    printf("吞吐量按去除计时开销（%lu ns）后的累计耗时计算\n", (unsigned long)overhead);
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            trace_t t;
+            if (load_trace(argv[i], &t)) {
+                run_trace(&t, overhead);
+            }
+        }
+        return 0;
+    }
+
+    trace_t (*generators[])(void) = { gen_producer_consumer, gen_power_law, gen_long_lived };
+    for (size_t i = 0; i < sizeof(generators) / sizeof(generators[0]); i++) {
+        trace_t t = generators[i]();
+        run_trace(&t, overhead);
+    }
+    return 0;
+}
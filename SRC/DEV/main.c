@@ -1,7 +1,7 @@
 #include "../LIB/utils.h"
+#include "../LIB/my_vsnprintf.h"
 
 extern void run_demo(void);
-extern int my_printf(const char *format, ...);
 
 int main() {
     my_printf("PBS项目演示程序启动\n");
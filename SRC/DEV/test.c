@@ -1,7 +1,7 @@
 #include <stdio.h>
 #include "../LIB/utils.h"
+#include "../LIB/my_vsnprintf.h"
 
-extern int my_printf(const char *format, ...);
 extern int my_scanf(const char *format, ...);
 // 示例模块函数
 void run_demo(void) {
@@ -0,0 +1,64 @@
+#include "arm_arena.h"
+#include "arm_malloc.h"
+
+// 创建 arena：描述结构与数据区放在同一次 arm_malloc 分配中
+arena_t *arena_create(size_t size) {
+    if (size == 0) {
+        return NULL;
+    }
+
+    size_t header = ALIGN(sizeof(arena_t));
+    size = ALIGN(size);
+    if (size > (size_t)-1 - header) {
+        return NULL;
+    }
+
+    arena_t *arena = (arena_t *)arm_malloc(header + size);
+    if (arena == NULL) {
+        return NULL;
+    }
+
+    arena->base = (char *)arena + header;
+    arena->size = size;
+    arena->offset = 0;
+    return arena;
+}
+
+void arena_destroy(arena_t *arena) {
+    arm_free(arena);
+}
+
+// 分配只是把偏移向前推进，空间不足时返回 NULL
+void *arena_alloc(arena_t *arena, size_t size) {
+    if (arena == NULL || size == 0) {
+        return NULL;
+    }
+
+    size_t aligned_size = ALIGN(size);
+    if (aligned_size < size || aligned_size > arena->size - arena->offset) {
+        return NULL;
+    }
+
+    void *ptr = arena->base + arena->offset;
+    arena->offset += aligned_size;
+    return ptr;
+}
+
+arena_mark_t arena_mark(const arena_t *arena) {
+    return arena != NULL ? arena->offset : 0;
+}
+
+// 回退到 mark，mark 之后的所有分配一次性失效
+void arena_reset_to_mark(arena_t *arena, arena_mark_t mark) {
+    if (arena != NULL && mark <= arena->offset) {
+        arena->offset = mark;
+    }
+}
+
+void arena_reset(arena_t *arena) {
+    arena_reset_to_mark(arena, 0);
+}
+
+size_t arena_remaining(const arena_t *arena) {
+    return arena != NULL ? arena->size - arena->offset : 0;
+}
@@ -0,0 +1,25 @@
+#ifndef ARM_ARENA_H
+#define ARM_ARENA_H
+
+#include <stddef.h>
+
+// 作用域暂存内存（bump 分配器）：从 arm_malloc 堆中取一整块，分配只是移动指针，
+// 通过 mark/reset 一次性释放一个作用域内的全部分配，单个分配不能单独释放。
+// 分配结果按 ALIGNMENT（16 字节）对齐。arena 不加锁。
+typedef struct arena {
+    char *base;      // 起始地址
+    size_t size;     // 总容量
+    size_t offset;   // 当前已用字节数
+} arena_t;
+
+typedef size_t arena_mark_t;
+
+arena_t *arena_create(size_t size);
+void arena_destroy(arena_t *arena);
+void *arena_alloc(arena_t *arena, size_t size);
+arena_mark_t arena_mark(const arena_t *arena);
+void arena_reset_to_mark(arena_t *arena, arena_mark_t mark);
+void arena_reset(arena_t *arena);
+size_t arena_remaining(const arena_t *arena);
+
+#endif // ARM_ARENA_H
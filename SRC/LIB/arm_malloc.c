@@ -1,236 +1,2429 @@
+#if defined(__linux__)
+#define _POSIX_C_SOURCE 200112L  // pthread 接口（主机构建）
+#endif
+
 #include "arm_malloc.h"
+#include "my_vsnprintf.h"
 #include <string.h>
 
-// 使用静态变量管理堆
-static void *heap_start = NULL;
-static size_t heap_size = 0;
-static block_meta *free_list = NULL;
-
-// 初始化堆
-void arm_malloc_init(void *start, size_t size) {
-    heap_start = start;
-    heap_size = size;
-    
-    // 初始化整个堆为一个大的空闲块
-    block_meta *first_block = (block_meta *)heap_start;
-    first_block->size = heap_size;
-    first_block->next = NULL;
-    first_block->free = 1;
-    
-    free_list = first_block;
-}
-
-// 分割内存块
-static void split_block(block_meta *block, size_t size) {
-    if (block->size > size + META_SIZE + ALIGNMENT) {
-        // 计算新块的位置
-        block_meta *new_block = (block_meta *)((char *)block + META_SIZE + size);
-        
-        // 设置新块的元数据
-        new_block->size = block->size - size - META_SIZE;
-        new_block->free = 1;
-        new_block->next = block->next;
-        
-        // 更新原块的大小和指针
-        block->size = size;
-        block->next = new_block;
-    }
-}
-
-// 合并相邻的空闲块
-static void coalesce_blocks() {
-    block_meta *current = free_list;
-    while (current != NULL && current->next != NULL) {
-        // 检查当前块和下一个块是否相邻且都是空闲的
-        if ((char *)current + META_SIZE + current->size == (char *)current->next) {
-            // 合并块
-            current->size += META_SIZE + current->next->size;
-            current->next = current->next->next;
-        } else {
-            current = current->next;
+#if defined(__linux__)
+#include <pthread.h>
+#endif
+
+// 可分割出的最小剩余块（元数据 + 一个对齐单位）
+#define MIN_SPLIT_SIZE (META_SIZE + ALIGNMENT)
+
+// 堆末尾保留的字节，供最后一块借用后继 prev_size 字段
+#define HEAP_TAIL_SIZE ALIGN(HEADER_OVERLAP)
+
+// 请求大小换算为块负载大小：紧凑块头下占用块还可使用后继块的 prev_size 字段；
+// 负载至少一个 ALIGNMENT，空闲时足以存放 next/prev
+static inline size_t payload_size(size_t size) {
+    size_t payload = ALIGN(size > HEADER_OVERLAP ? size - HEADER_OVERLAP : 0);
+    return payload < ALIGNMENT ? ALIGNMENT : payload;
+}
+
+// ---------------------------------------------------------------------------
+// TLSF 参数
+// 一级索引按 2 的幂划分，二级索引把每个一级区间线性等分为 SL_INDEX_COUNT 份。
+// 小于 SMALL_BLOCK_SIZE 的块全部落在一级索引 0，按 ALIGNMENT 线性划分。
+// ---------------------------------------------------------------------------
+#define SL_INDEX_COUNT_LOG2 4
+#define SL_INDEX_COUNT      (1 << SL_INDEX_COUNT_LOG2)
+#define FL_INDEX_SHIFT      (SL_INDEX_COUNT_LOG2 + 4)   // log2(ALIGNMENT) = 4
+#define FL_INDEX_MAX        32                          // 支持最大 4 GiB 的块
+#define FL_INDEX_COUNT      (FL_INDEX_MAX - FL_INDEX_SHIFT + 1)
+#define SMALL_BLOCK_SIZE    ((size_t)1 << FL_INDEX_SHIFT)
+
+// 索引表能容纳的最大块为 2^FL_INDEX_MAX - 1 字节，heap_create 截断更大的区域，
+// 合并得到的块也不会超出。size_t 为 32 位时结果为 SIZE_MAX，不截断
+#define TLSF_REGION_MAX     ((((size_t)1 << (FL_INDEX_MAX - 1)) << 1) - 1)
+
+// 分离适配桶：第 i 个桶保存大小在 (16 << (i-1), 16 << i] 之间的空闲块，
+// 最后一个桶保存其余所有更大的块
+#define NUM_BUCKETS 20
+
+// 小块按精确大小分类，供快速箱和线程缓存共用
+#define SMALL_MAX_SIZE     512
+#define NUM_SMALL_CLASSES  (SMALL_MAX_SIZE / ALIGNMENT)
+
+static inline int small_class(size_t size) {
+    return (int)(size / ALIGNMENT) - 1;
+}
+
+// ---------------------------------------------------------------------------
+// 锁：主机构建使用 pthread 互斥量，裸机使用自旋锁。
+// 关闭 ARM_MALLOC_THREAD_SAFE 时为空操作，适用于单线程固件
+// ---------------------------------------------------------------------------
+#if !ARM_MALLOC_THREAD_SAFE
+typedef int heap_mutex_t;
+#define HEAP_MUTEX_INIT 0
+
+static inline void mutex_init(heap_mutex_t *mutex) {
+    (void)mutex;
+}
+
+static inline void mutex_lock(heap_mutex_t *mutex) {
+    (void)mutex;
+}
+
+static inline void mutex_unlock(heap_mutex_t *mutex) {
+    (void)mutex;
+}
+#elif defined(__linux__)
+typedef pthread_mutex_t heap_mutex_t;
+#define HEAP_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+
+static inline void mutex_init(heap_mutex_t *mutex) {
+    pthread_mutex_init(mutex, NULL);
+}
+
+static inline void mutex_lock(heap_mutex_t *mutex) {
+    pthread_mutex_lock(mutex);
+}
+
+static inline void mutex_unlock(heap_mutex_t *mutex) {
+    pthread_mutex_unlock(mutex);
+}
+#else
+typedef volatile uint32_t heap_mutex_t;
+#define HEAP_MUTEX_INIT 0
+
+static inline void mutex_init(heap_mutex_t *mutex) {
+    *mutex = 0;
+}
+
+static inline void mutex_lock(heap_mutex_t *mutex) {
+    while (__atomic_exchange_n(mutex, 1, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(mutex, __ATOMIC_RELAXED)) {
+#if defined(__aarch64__)
+            __asm__ volatile("yield");
+#endif
+        }
+    }
+}
+
+static inline void mutex_unlock(heap_mutex_t *mutex) {
+    __atomic_store_n(mutex, 0, __ATOMIC_RELEASE);
+}
+#endif
+
+#if ARM_MALLOC_THREAD_SAFE
+// 快速箱栈顶，见下方快速箱一节
+#define QBIN_LIMIT 64  // 每个大小类最多暂存的块数（近似值）
+
+typedef struct {
+#if defined(__aarch64__)
+    block_meta *head;
+#else
+    uint64_t head;     // 高 32 位为版本号，低 32 位为块偏移 / ALIGNMENT + 1，0 表示空
+#endif
+    uint32_t count;
+} qbin_t;
+#endif
+
+#if ARM_MALLOC_TINY
+// 微小对象层参数，见下方微小对象一节
+#define TINY_MAX_SIZE      64
+#define TINY_CLASSES       (TINY_MAX_SIZE / ALIGNMENT)   // 16/32/48/64 字节
+#define TINY_RUN_SIZE      4096                          // 每个 run 一页，按页对齐
+#define TINY_BITMAP_WORDS  (TINY_RUN_SIZE / ALIGNMENT / 64)
+
+typedef struct tiny_run {
+    struct tiny_run *next;        // 同一大小类中仍有空槽的 run
+    struct tiny_run *prev;
+    uint32_t slot_reciprocal;     // 65536 / (slot_size / ALIGNMENT) 向上取整，用于求槽号
+    uint16_t slot_size;
+    uint16_t slot_count;
+    uint16_t free_count;
+    uint64_t bitmap[TINY_BITMAP_WORDS];  // 置位表示空槽
+} tiny_run;
+
+#define TINY_HEADER_SIZE   ALIGN(sizeof(tiny_run))
+#endif
+
+#if ARM_MALLOC_HANDLES
+// 句柄表分为固定大小的分块，每块一个可搬移的堆块，见下方句柄一节
+#define HANDLE_CHUNK_SLOTS  128
+#define HANDLE_MAX_CHUNKS   ((ARM_MALLOC_MAX_HANDLES + HANDLE_CHUNK_SLOTS - 1) / HANDLE_CHUNK_SLOTS)
+
+// 句柄表条目
+typedef struct {
+    block_meta *block;            // 句柄块，NULL 表示条目空闲
+    uint32_t lock_count;
+    uint32_t next_free;           // 空闲条目链：下一个空闲槽号 + 1，0 结束
+} handle_entry;
+#endif
+
+// ---------------------------------------------------------------------------
+// 堆对象：每个内存区域一份完整的分配器状态，描述符放在区域开头或调用者提供的存储中。
+// 所有堆登记在 heaps[] 中，释放时按地址范围找到所属的堆
+// ---------------------------------------------------------------------------
+struct heap {
+    char *region;                 // 区域起始，描述符在区域内时即描述符地址
+    char *start;                  // 第一个块的地址（描述符与页位图之后）
+    size_t size;
+    char *end;
+    arm_malloc_mode mode;
+    unsigned generation;          // 创建代数，用于作废旧堆的线程缓存与计数
+    int index;                    // 在 heaps[] 中的位置
+    heap_t *fallback;             // 本堆无法满足时转向的堆
+    heap_mutex_t lock;
+
+    // 首次适应引擎的空闲链表
+    block_meta *free_list;
+
+    // TLSF 引擎
+    uint32_t fl_bitmap;
+    uint32_t sl_bitmap[FL_INDEX_COUNT];
+    block_meta *tlsf_blocks[FL_INDEX_COUNT][SL_INDEX_COUNT];
+
+    // 分离适配引擎，非空桶记录在 bucket_bitmap 中
+    uint32_t bucket_bitmap;
+    block_meta *free_buckets[NUM_BUCKETS];
+
+    // 共享堆计数器（持有堆锁时以 O(1) 维护）
+    size_t free_bytes;            // 空闲块负载总和
+    size_t free_block_count;
+    size_t peak_heap_used;        // 共享堆占用（含元数据）的峰值
+
+    // 清零跟踪：untouched 是写入的高水位，之后的字节从未被分配器或调用者写过。
+    // 区域声明为已清零时，calloc 只需清除块中低于高水位的部分
+    char *untouched;
+    int zeroed;
+
+#if ARM_MALLOC_THREAD_SAFE
+    qbin_t qbins[NUM_SMALL_CLASSES];
+#endif
+
+#if ARM_MALLOC_TINY
+    uintptr_t tiny_base;          // 页位图第 0 位对应的页地址
+    uint32_t *tiny_map;           // 每页一位，置位表示该页是 run（位于描述符之后）
+    tiny_run *tiny_partial[TINY_CLASSES];
+    heap_mutex_t tiny_locks[TINY_CLASSES];
+#endif
+
+#if ARM_MALLOC_DEFER_QUEUE > 0
+    block_meta *deferred[ARM_MALLOC_DEFER_QUEUE];  // 延迟合并队列（环形，deferred_head 处最早）
+    size_t deferred_size[ARM_MALLOC_DEFER_QUEUE];  // 对应块的负载大小，空位为 0，查找时不必访问块头
+    unsigned deferred_head;
+    unsigned deferred_count;
+#endif
+
+#if ARM_MALLOC_HANDLES
+    handle_entry *handle_chunks[HANDLE_MAX_CHUNKS];
+    uint32_t handle_chunk_count;
+    uint32_t handle_free;         // 空闲条目链头：槽号 + 1，0 表示没有
+    block_meta *compact_cursor;   // 整理进度：下次从这个已占用块继续，NULL 表示从头开始
+#endif
+};
+
+#define HEAP_DESC_SIZE ALIGN(sizeof(heap_t))
+
+// 头文件中的 ARM_HEAP_DESC_SIZE 供调用者定义静态存储，必须不小于实际描述符
+typedef char heap_desc_size_check[(HEAP_DESC_SIZE <= ARM_HEAP_DESC_SIZE) ? 1 : -1];
+
+static heap_t *heaps[ARM_MALLOC_MAX_HEAPS];
+static heap_t *default_heap = NULL;          // arm_malloc 等接口使用的堆
+static unsigned heap_generation = 0;         // 每次创建堆递增
+static heap_mutex_t registry_mutex = HEAP_MUTEX_INIT;  // 保护 heaps[] 与线程链表
+
+static void retired_stats_reset(int index);
+
+static inline void heap_lock(heap_t *h) {
+    mutex_lock(&h->lock);
+}
+
+static inline void heap_unlock(heap_t *h) {
+    mutex_unlock(&h->lock);
+}
+
+// 由指针找到所属的堆，先检查默认堆
+static inline heap_t *heap_from_ptr(const void *ptr) {
+    const char *p = (const char *)ptr;
+    heap_t *h = default_heap;
+    if (h != NULL && p >= h->start && p < h->end) {
+        return h;
+    }
+    for (int i = 0; i < ARM_MALLOC_MAX_HEAPS; i++) {
+        h = heaps[i];
+        if (h != NULL && p >= h->start && p < h->end) {
+            return h;
+        }
+    }
+    return NULL;
+}
+
+// 最高置位（count-leading-zeros），ARMv8 上编译为单条 CLZ 指令
+static inline int arm_fls(size_t x) {
+    return (int)(sizeof(size_t) * 8 - 1) - __builtin_clzl(x);
+}
+
+// 最低置位（count-trailing-zeros），ARMv8 上编译为 RBIT + CLZ
+static inline int arm_ffs(uint32_t x) {
+    return __builtin_ctz(x);
+}
+
+static inline size_t block_size(const block_meta *block) {
+    return block->size & ~BLOCK_FLAGS;
+}
+
+static inline void block_set_size(block_meta *block, size_t size) {
+    block->size = size | (block->size & BLOCK_FLAGS);
+}
+
+static inline int block_is_free(const block_meta *block) {
+    return (block->size & BLOCK_FREE) != 0;
+}
+
+// 物理上相邻的下一个块，位于堆末尾时返回 NULL
+static inline block_meta *next_phys_block(heap_t *h, block_meta *block) {
+    char *next = (char *)block + META_SIZE + block_size(block);
+    return next < h->end ? (block_meta *)next : NULL;
+}
+
+// 物理上相邻的前一个块，通过边界标签定位，仅当前一块空闲时可用
+static inline block_meta *prev_phys_block(block_meta *block) {
+    return (block_meta *)((char *)block - block->prev_size - META_SIZE);
+}
+
+// 由块大小计算所在的一级/二级索引
+static void tlsf_mapping_insert(size_t size, int *fl, int *sl) {
+    if (size < SMALL_BLOCK_SIZE) {
+        *fl = 0;
+        *sl = (int)(size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT));
+    } else {
+        int f = arm_fls(size);
+        *sl = (int)(size >> (f - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT;
+        *fl = f - (FL_INDEX_SHIFT - 1);
+    }
+}
+
+// 查找时把大小向上取整到下一个二级区间，保证该区间内的任意块都能满足请求
+static void tlsf_mapping_search(size_t size, int *fl, int *sl) {
+    if (size >= SMALL_BLOCK_SIZE) {
+        size += ((size_t)1 << (arm_fls(size) - SL_INDEX_COUNT_LOG2)) - 1;
+    }
+    tlsf_mapping_insert(size, fl, sl);
+}
+
+static void tlsf_insert_block(heap_t *h, block_meta *block) {
+    int fl, sl;
+    tlsf_mapping_insert(block_size(block), &fl, &sl);
+
+    block->prev = NULL;
+    block->next = h->tlsf_blocks[fl][sl];
+    if (block->next != NULL) {
+        block->next->prev = block;
+    }
+    h->tlsf_blocks[fl][sl] = block;
+
+    h->fl_bitmap |= 1U << fl;
+    h->sl_bitmap[fl] |= 1U << sl;
+}
+
+static void tlsf_remove_block(heap_t *h, block_meta *block) {
+    int fl, sl;
+    tlsf_mapping_insert(block_size(block), &fl, &sl);
+
+    if (block->prev != NULL) {
+        block->prev->next = block->next;
+    } else {
+        h->tlsf_blocks[fl][sl] = block->next;
+    }
+    if (block->next != NULL) {
+        block->next->prev = block->prev;
+    }
+
+    // 链表为空时清除对应的位图位
+    if (h->tlsf_blocks[fl][sl] == NULL) {
+        h->sl_bitmap[fl] &= ~(1U << sl);
+        if (h->sl_bitmap[fl] == 0) {
+            h->fl_bitmap &= ~(1U << fl);
+        }
+    }
+}
+
+// 用位图在常数时间内找到不小于请求大小的非空链表
+static block_meta *tlsf_find_block(heap_t *h, size_t size) {
+    int fl, sl;
+    tlsf_mapping_search(size, &fl, &sl);
+
+    uint32_t sl_map = (fl < FL_INDEX_COUNT) ? h->sl_bitmap[fl] & (~0U << sl) : 0;
+    if (sl_map == 0) {
+        // 当前一级区间没有合适的块，转到更大的一级区间
+        uint32_t fl_map = (fl + 1 < FL_INDEX_COUNT) ? h->fl_bitmap & (~0U << (fl + 1)) : 0;
+        if (fl_map != 0) {
+            fl = arm_ffs(fl_map);
+            sl_map = h->sl_bitmap[fl];
+        }
+    }
+    if (sl_map != 0) {
+        sl = arm_ffs(sl_map);
+        return h->tlsf_blocks[fl][sl];
+    }
+
+    // 向上取整后没有可用区间时，退回到请求大小所在的区间逐个检查，
+    // 避免堆中最大的块因取整而无法被使用（只在即将失败时发生）
+    tlsf_mapping_insert(size, &fl, &sl);
+    if (fl >= FL_INDEX_COUNT) {
+        return NULL;
+    }
+    for (block_meta *current = h->tlsf_blocks[fl][sl]; current != NULL; current = current->next) {
+        if (block_size(current) >= size) {
+            return current;
+        }
+    }
+    return NULL;
+}
+
+// 根据大小确定桶索引：满足 16 << index >= size 的最小 index
+static int get_bucket_index(size_t size) {
+    if (size <= ALIGNMENT) {
+        return 0;
+    }
+
+    int index = arm_fls(size - 1) - 3;
+    return index < NUM_BUCKETS ? index : NUM_BUCKETS - 1;
+}
+
+static void bucket_insert_block(heap_t *h, block_meta *block) {
+    int index = get_bucket_index(block_size(block));
+
+    block->prev = NULL;
+    block->next = h->free_buckets[index];
+    if (block->next != NULL) {
+        block->next->prev = block;
+    }
+    h->free_buckets[index] = block;
+    h->bucket_bitmap |= 1U << index;
+}
+
+static void bucket_remove_block(heap_t *h, block_meta *block) {
+    int index = get_bucket_index(block_size(block));
+
+    if (block->prev != NULL) {
+        block->prev->next = block->next;
+    } else {
+        h->free_buckets[index] = block->next;
+    }
+    if (block->next != NULL) {
+        block->next->prev = block->prev;
+    }
+
+    if (h->free_buckets[index] == NULL) {
+        h->bucket_bitmap &= ~(1U << index);
+    }
+}
+
+// 在单个桶内做最佳适应，遇到大小完全相同的块立即返回。
+// limit 不为 0 时最多检查 limit 个块，使查找耗时不随桶长度增长
+#define BUCKET_SCAN_LIMIT 8
+static block_meta *bucket_best_fit(heap_t *h, int index, size_t size, int limit) {
+    block_meta *best = NULL;
+    int candidates = 0;
+    for (block_meta *current = h->free_buckets[index]; current != NULL; current = current->next) {
+        size_t current_size = block_size(current);
+        if (current_size >= size && (best == NULL || current_size < block_size(best))) {
+            best = current;
+            if (current_size == size) {
+                break;
+            }
+        }
+        if (++candidates == limit) {
+            break;
+        }
+    }
+    return best;
+}
+
+// 优化后的查找函数：先在请求所在的桶内最佳适应，
+// 再用位图跳到下一个非空桶（其中任意块都足够大）。
+// 没有更高的非空桶时（包括请求落在最后一个桶），把请求所在的桶查完再报告失败
+static block_meta *find_free_block_optimized(heap_t *h, size_t size) {
+    int bucket_index = get_bucket_index(size);
+
+    block_meta *best = bucket_best_fit(h, bucket_index, size, BUCKET_SCAN_LIMIT);
+    if (best != NULL) {
+        return best;
+    }
+
+    uint32_t map = (bucket_index + 1 < NUM_BUCKETS) ? h->bucket_bitmap & (~0U << (bucket_index + 1)) : 0;
+    if (map == 0) {
+        return bucket_best_fit(h, bucket_index, size, 0);
+    }
+    return bucket_best_fit(h, arm_ffs(map), size, BUCKET_SCAN_LIMIT);
+}
+
+// ---------------------------------------------------------------------------
+// 空闲块索引：根据引擎把空闲块放入/移出对应的数据结构
+// ---------------------------------------------------------------------------
+static void free_list_insert(heap_t *h, block_meta *block) {
+    // 更新状态位，并把边界标签写入物理后继块
+    block->size |= BLOCK_FREE;
+    h->free_bytes += block_size(block);
+    h->free_block_count++;
+    block_meta *next = next_phys_block(h, block);
+    if (next != NULL) {
+        next->prev_size = block_size(block);
+        next->size |= BLOCK_PREV_FREE;
+    }
+
+    switch (h->mode) {
+    case ARM_MALLOC_TLSF:
+        tlsf_insert_block(h, block);
+        break;
+    case ARM_MALLOC_SEGREGATED:
+        bucket_insert_block(h, block);
+        break;
+    default:
+        block->prev = NULL;
+        block->next = h->free_list;
+        if (h->free_list != NULL) {
+            h->free_list->prev = block;
+        }
+        h->free_list = block;
+        break;
+    }
+}
+
+static void free_list_remove(heap_t *h, block_meta *block) {
+    switch (h->mode) {
+    case ARM_MALLOC_TLSF:
+        tlsf_remove_block(h, block);
+        break;
+    case ARM_MALLOC_SEGREGATED:
+        bucket_remove_block(h, block);
+        break;
+    default:
+        if (block->prev != NULL) {
+            block->prev->next = block->next;
+        } else {
+            h->free_list = block->next;
+        }
+        if (block->next != NULL) {
+            block->next->prev = block->prev;
+        }
+        break;
+    }
+    block->next = NULL;
+    block->prev = NULL;
+    block->size &= ~BLOCK_FREE;
+    h->free_bytes -= block_size(block);
+    h->free_block_count--;
+
+    block_meta *next = next_phys_block(h, block);
+    if (next != NULL) {
+        next->size &= ~BLOCK_PREV_FREE;
+    }
+}
+
+// 从登记表中移除堆，并清除其他堆指向它的回退（调用者持有 registry_mutex）
+static void heap_unregister(heap_t *h) {
+    for (int i = 0; i < ARM_MALLOC_MAX_HEAPS; i++) {
+        if (heaps[i] == h) {
+            heaps[i] = NULL;
+        } else if (heaps[i] != NULL && heaps[i]->fallback == h) {
+            heaps[i]->fallback = NULL;
+        }
+    }
+    if (default_heap == h) {
+        default_heap = NULL;
+    }
+}
+
+// 在一段内存上创建堆。desc 为 NULL 时描述符放在区域开头，
+// 否则放在调用者提供的存储中，区域全部用作块区
+heap_t *heap_create_at(void *desc, size_t desc_size, void *start, size_t size, arm_malloc_mode mode) {
+    if (start == NULL) {
+        return NULL;
+    }
+    // 超出 TLSF 索引范围的部分不使用，保证任何空闲块都能映射到 tlsf_blocks[] 之内
+    if (size > TLSF_REGION_MAX) {
+        size = TLSF_REGION_MAX;
+    }
+
+    // 描述符按 ALIGNMENT 对齐，其后（或区域开头）为块区，大小向下取整
+    char *region_end = (char *)start + size;
+    heap_t *h;
+    char *blocks;
+    if (desc == NULL) {
+        uintptr_t aligned_start = ALIGN((uintptr_t)start);
+        if (size < aligned_start - (uintptr_t)start + HEAP_DESC_SIZE + MIN_SPLIT_SIZE + HEAP_TAIL_SIZE) {
+            return NULL;
+        }
+        h = (heap_t *)aligned_start;
+        blocks = (char *)h + HEAP_DESC_SIZE;
+    } else {
+        uintptr_t aligned_desc = ALIGN((uintptr_t)desc);
+        if (desc_size < aligned_desc - (uintptr_t)desc + HEAP_DESC_SIZE) {
+            return NULL;
+        }
+        uintptr_t aligned_start = ALIGN((uintptr_t)start);
+        if (size < aligned_start - (uintptr_t)start) {
+            return NULL;
+        }
+        h = (heap_t *)aligned_desc;
+        blocks = (char *)aligned_start;
+    }
+#if ARM_MALLOC_TINY
+    // 微小对象页位图放在块区开头，覆盖块区的每一页
+    uintptr_t tiny_base = (uintptr_t)blocks & ~(uintptr_t)(TINY_RUN_SIZE - 1);
+    size_t pages = ((uintptr_t)region_end - tiny_base + TINY_RUN_SIZE - 1) / TINY_RUN_SIZE;
+    uint32_t *tiny_map = (uint32_t *)blocks;
+    blocks += ALIGN((pages + 31) / 32 * sizeof(uint32_t));
+#endif
+    if (region_end < blocks || (size_t)(region_end - blocks) < ALIGNMENT + MIN_SPLIT_SIZE + HEAP_TAIL_SIZE) {
+        return NULL;
+    }
+
+    mutex_lock(&registry_mutex);
+    // 与新区域或新描述符重叠的旧堆（例如在同一缓冲区上重新初始化）直接作废
+    int index = -1;
+    for (int i = 0; i < ARM_MALLOC_MAX_HEAPS; i++) {
+        heap_t *old = heaps[i];
+        if (old != NULL && ((old->region < region_end && old->end > (char *)start) ||
+                            ((char *)old < (char *)h + HEAP_DESC_SIZE && (char *)h < (char *)old + HEAP_DESC_SIZE))) {
+            heap_unregister(old);
+        }
+    }
+    for (int i = 0; i < ARM_MALLOC_MAX_HEAPS; i++) {
+        if (heaps[i] == NULL) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        mutex_unlock(&registry_mutex);
+        return NULL;
+    }
+
+    memset(h, 0, sizeof(*h));
+    mutex_init(&h->lock);
+    h->mode = mode;
+    h->index = index;
+    h->generation = ++heap_generation;
+    h->region = (desc == NULL) ? (char *)h : (char *)start;
+    h->start = blocks;
+    h->size = ((size_t)(region_end - blocks) & ~(size_t)(ALIGNMENT - 1)) - HEAP_TAIL_SIZE;
+    h->end = h->start + h->size;
+#if ARM_MALLOC_TINY
+    h->tiny_base = tiny_base;
+    h->tiny_map = tiny_map;
+    memset(tiny_map, 0, (size_t)(blocks - (char *)tiny_map));
+    for (int cls = 0; cls < TINY_CLASSES; cls++) {
+        mutex_init(&h->tiny_locks[cls]);
+    }
+#endif
+    retired_stats_reset(index);
+
+    // 初始化整个块区为一个大的空闲块
+    block_meta *first_block = (block_meta *)h->start;
+    first_block->prev_size = 0;
+    first_block->size = h->size - META_SIZE;
+    free_list_insert(h, first_block);
+    h->untouched = h->start + sizeof(block_meta);
+
+    heaps[index] = h;
+    mutex_unlock(&registry_mutex);
+    return h;
+}
+
+heap_t *heap_create(void *start, size_t size, arm_malloc_mode mode) {
+    return heap_create_at(NULL, 0, start, size, mode);
+}
+
+void heap_destroy(heap_t *h) {
+    if (h == NULL) {
+        return;
+    }
+    mutex_lock(&registry_mutex);
+    heap_unregister(h);
+    mutex_unlock(&registry_mutex);
+}
+
+// 设置回退堆，拒绝形成环
+int heap_set_fallback(heap_t *h, heap_t *fallback) {
+    if (h == NULL) {
+        return -1;
+    }
+
+    mutex_lock(&registry_mutex);
+    for (heap_t *current = fallback; current != NULL; current = current->fallback) {
+        if (current == h) {
+            mutex_unlock(&registry_mutex);
+            return -1;
+        }
+    }
+    h->fallback = fallback;
+    mutex_unlock(&registry_mutex);
+    return 0;
+}
+
+// 声明高水位之后的内存为零，例如区域位于 .bss 或已由启动代码清零
+void heap_assume_zeroed(heap_t *h) {
+    if (h == NULL) {
+        return;
+    }
+    heap_lock(h);
+    h->zeroed = 1;
+    heap_unlock(h);
+}
+
+heap_t *arm_malloc_default_heap(void) {
+    return default_heap;
+}
+
+void arm_malloc_set_default_heap(heap_t *h) {
+    default_heap = h;
+}
+
+// 初始化默认堆，原有的默认堆被丢弃
+int arm_malloc_init_mode(void *start, size_t size, arm_malloc_mode mode) {
+    heap_destroy(default_heap);
+    default_heap = heap_create(start, size, mode);
+    return default_heap != NULL ? 0 : -1;
+}
+
+int arm_malloc_init(void *start, size_t size) {
+    return arm_malloc_init_mode(start, size, ARM_MALLOC_TLSF);
+}
+
+// 分割内存块，剩余部分作为新的空闲块放回空闲索引
+static void split_block(heap_t *h, block_meta *block, size_t size) {
+    if (block_size(block) >= size + MIN_SPLIT_SIZE) {
+        // 计算新块的位置
+        block_meta *new_block = (block_meta *)((char *)block + META_SIZE + size);
+
+        // 设置新块的元数据（前一块即原块，已被占用）
+        new_block->size = block_size(block) - size - META_SIZE;
+
+        // 更新原块的大小
+        block_set_size(block, size);
+
+        free_list_insert(h, new_block);
+    }
+}
+
+// 借助边界标签与物理前后相邻的空闲块合并，返回合并后的块
+static block_meta *coalesce_block(heap_t *h, block_meta *block) {
+    if (block->size & BLOCK_PREV_FREE) {
+        block_meta *prev = prev_phys_block(block);
+        free_list_remove(h, prev);
+        block_set_size(prev, block_size(prev) + META_SIZE + block_size(block));
+        block = prev;
+    }
+
+    block_meta *next = next_phys_block(h, block);
+    if (next != NULL && block_is_free(next)) {
+        free_list_remove(h, next);
+        block_set_size(block, block_size(block) + META_SIZE + block_size(next));
+    }
+
+    return block;
+}
+
+// 寻找合适的空闲块（首次适应算法）
+static block_meta *find_free_block(heap_t *h, size_t size) {
+    block_meta *current = h->free_list;
+
+    // 使用首次适应算法
+    while (current != NULL) {
+        if (block_size(current) >= size) {
+            return current;
+        }
+        current = current->next;
+    }
+
+    return NULL; // 没有找到合适的块
+}
+
+// 块即将交给调用者：抬高写入高水位。块尾之后还会写入分割出的空闲块头部与链接，
+// 调用者也可能借用后继块的 prev_size，因此多算一个 block_meta（调用者持有堆锁）
+static inline void mark_touched(heap_t *h, block_meta *block) {
+    char *end = (char *)block + META_SIZE + block_size(block) + sizeof(block_meta);
+    if (end > h->untouched) {
+        h->untouched = end;
+    }
+}
+
+// 共享堆占用增加后更新峰值：分配新块和 realloc 原地扩大时调用（调用者持有堆锁）
+static inline void heap_update_peak(heap_t *h) {
+    size_t used = h->size - h->free_bytes - h->free_block_count * META_SIZE;
+    if (used > h->peak_heap_used) {
+        h->peak_heap_used = used;
+    }
+}
+
+// 从共享堆中取出一个块（调用者持有堆锁）
+static block_meta *alloc_block(heap_t *h, size_t aligned_size) {
+    // 寻找合适的空闲块
+    block_meta *block;
+    switch (h->mode) {
+    case ARM_MALLOC_TLSF:
+        block = tlsf_find_block(h, aligned_size);
+        break;
+    case ARM_MALLOC_SEGREGATED:
+        block = find_free_block_optimized(h, aligned_size);
+        break;
+    default:
+        block = find_free_block(h, aligned_size);
+        break;
+    }
+    if (block == NULL) {
+        // 没有可用的空闲块
+        return NULL;
+    }
+
+    free_list_remove(h, block);
+    split_block(h, block, aligned_size);
+    mark_touched(h, block);
+
+    heap_update_peak(h);
+    return block;
+}
+
+// 块将被释放或并入相邻块：若整理游标停在这里，下次整理改为从头开始
+static inline void compact_forget(heap_t *h, block_meta *block) {
+#if ARM_MALLOC_HANDLES
+    if (h->compact_cursor == block) {
+        h->compact_cursor = NULL;
+    }
+#else
+    (void)h;
+    (void)block;
+#endif
+}
+
+// 把块归还共享堆（调用者持有堆锁）
+static void release_block(heap_t *h, block_meta *block) {
+    compact_forget(h, block);
+    // 边界标签让前后合并都是常数时间，不再依赖空闲链表的顺序
+    free_list_insert(h, coalesce_block(h, block));
+}
+
+// 把已占用块超出 size 的尾部切下还给共享堆，尾部会与右侧的空闲块合并（调用者持有堆锁）
+static void shrink_block(heap_t *h, block_meta *block, size_t size) {
+    if (block_size(block) < size + MIN_SPLIT_SIZE) {
+        return;
+    }
+
+    block_meta *tail = (block_meta *)((char *)block + META_SIZE + size);
+    tail->size = block_size(block) - size - META_SIZE;
+    block_set_size(block, size);
+    release_block(h, tail);
+}
+
+// 在以 aligned_size + alignment + MIN_SPLIT_SIZE 取出的块中定出对齐的负载：
+// 前导空隙切成独立的空闲块，尾部多余部分还给堆（调用者持有堆锁）
+static block_meta *align_block(heap_t *h, block_meta *block, size_t alignment, size_t aligned_size) {
+    // 找到第一个对齐位置，使前导空隙为 0 或足以构成一个最小空闲块
+    uintptr_t payload = (uintptr_t)block + META_SIZE;
+    uintptr_t aligned = (payload + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    if (aligned != payload && aligned - payload < MIN_SPLIT_SIZE) {
+        aligned += alignment;
+    }
+
+    if (aligned != payload) {
+        size_t gap = aligned - payload;
+        block_meta *aligned_block = (block_meta *)(aligned - META_SIZE);
+        aligned_block->size = block_size(block) - gap;
+        block_set_size(block, gap - META_SIZE);
+        release_block(h, block);
+        block = aligned_block;
+    }
+    shrink_block(h, block, aligned_size);
+    return block;
+}
+
+#if ARM_MALLOC_DEFER_QUEUE > 0
+// ---------------------------------------------------------------------------
+// 延迟合并：较大的块释放时先放进有界队列，保持占用状态、不参与合并；
+// 大小合适的请求直接从队列复用，省去查找与分割。队列满时只把最早的块合并回堆，
+// 单次释放至多做一次常数时间的合并（以下函数的调用者都持有堆锁）
+// ---------------------------------------------------------------------------
+// 移出队首（最早）的一项
+static inline void defer_pop_head(heap_t *h) {
+    h->deferred_size[h->deferred_head] = 0;
+    h->deferred_head = (h->deferred_head + 1) % ARM_MALLOC_DEFER_QUEUE;
+    h->deferred_count--;
+}
+
+static void defer_free(heap_t *h, block_meta *block) {
+    if (h->deferred_count == ARM_MALLOC_DEFER_QUEUE) {
+        release_block(h, h->deferred[h->deferred_head]);
+        defer_pop_head(h);
+    }
+    unsigned tail = (h->deferred_head + h->deferred_count) % ARM_MALLOC_DEFER_QUEUE;
+    h->deferred[tail] = block;
+    h->deferred_size[tail] = block_size(block);
+    h->deferred_count++;
+}
+
+// 取一个无需分割即可满足请求的块，用最早的一项填补取出的位置。
+// 直接扫描整个数组（空位大小为 0，无符号差值判断一次比较即可），分支更容易预测
+static block_meta *defer_take(heap_t *h, size_t aligned_size) {
+    for (unsigned pos = 0; pos < ARM_MALLOC_DEFER_QUEUE; pos++) {
+        if (h->deferred_size[pos] - aligned_size < MIN_SPLIT_SIZE) {
+            block_meta *block = h->deferred[pos];
+            h->deferred[pos] = h->deferred[h->deferred_head];
+            h->deferred_size[pos] = h->deferred_size[h->deferred_head];
+            defer_pop_head(h);
+            return block;
+        }
+    }
+    return NULL;
+}
+
+static void defer_flush(heap_t *h) {
+    while (h->deferred_count > 0) {
+        release_block(h, h->deferred[h->deferred_head]);
+        defer_pop_head(h);
+    }
+}
+#else
+static void defer_free(heap_t *h, block_meta *block) {
+    release_block(h, block);
+}
+
+static block_meta *defer_take(heap_t *h, size_t aligned_size) {
+    (void)h;
+    (void)aligned_size;
+    return NULL;
+}
+
+static void defer_flush(heap_t *h) {
+    (void)h;
+}
+#endif // ARM_MALLOC_DEFER_QUEUE
+
+#if ARM_MALLOC_TINY
+// ---------------------------------------------------------------------------
+// 微小对象层：不超过 TINY_MAX_SIZE 的请求按 16 字节一档分为 TINY_CLASSES 个大小类，
+// 每类从整页的 run 中分配。run 头部的位图记录空槽，分配时用 ctz 取最低置位，
+// 对象本身不带块头。run 是按页对齐的普通块，堆的页位图为每页记一位，
+// 释放时把指针按页取整即可在 O(1) 内判断它是否属于某个 run。
+// 每个大小类一把锁，新建和归还 run 时再进入堆锁（顺序固定为先类锁后堆锁）。
+// ---------------------------------------------------------------------------
+static inline int tiny_class(size_t size) {
+    return (int)((size - 1) / ALIGNMENT);
+}
+
+static inline size_t tiny_page(heap_t *h, const void *ptr) {
+    return ((uintptr_t)ptr - h->tiny_base) / TINY_RUN_SIZE;
+}
+
+// 指针所在的页是否是 run
+static inline int tiny_owns(heap_t *h, const void *ptr) {
+    size_t page = tiny_page(h, ptr);
+    return (__atomic_load_n(&h->tiny_map[page / 32], __ATOMIC_RELAXED) >> (page % 32)) & 1;
+}
+
+static inline tiny_run *tiny_run_of(const void *ptr) {
+    return (tiny_run *)((uintptr_t)ptr & ~(uintptr_t)(TINY_RUN_SIZE - 1));
+}
+
+static void tiny_partial_insert(heap_t *h, int cls, tiny_run *run) {
+    run->prev = NULL;
+    run->next = h->tiny_partial[cls];
+    if (run->next != NULL) {
+        run->next->prev = run;
+    }
+    h->tiny_partial[cls] = run;
+}
+
+static void tiny_partial_remove(heap_t *h, int cls, tiny_run *run) {
+    if (run->prev != NULL) {
+        run->prev->next = run->next;
+    } else {
+        h->tiny_partial[cls] = run->next;
+    }
+    if (run->next != NULL) {
+        run->next->prev = run->prev;
+    }
+}
+
+// 从堆中取一页作为新 run（调用者持有类锁）
+static tiny_run *tiny_run_create(heap_t *h, int cls) {
+    heap_lock(h);
+    block_meta *block = alloc_block(h, TINY_RUN_SIZE + TINY_RUN_SIZE + MIN_SPLIT_SIZE);
+    if (block == NULL) {
+        heap_unlock(h);
+        return NULL;
+    }
+    block = align_block(h, block, TINY_RUN_SIZE, TINY_RUN_SIZE);
+    tiny_run *run = (tiny_run *)((char *)block + META_SIZE);
+    size_t page = tiny_page(h, run);
+    __atomic_fetch_or(&h->tiny_map[page / 32], 1U << (page % 32), __ATOMIC_RELAXED);
+    heap_unlock(h);
+
+    run->slot_size = (uint16_t)((cls + 1) * ALIGNMENT);
+    run->slot_reciprocal = (uint32_t)((65536 + cls) / (cls + 1));
+    run->slot_count = (uint16_t)((TINY_RUN_SIZE - TINY_HEADER_SIZE) / run->slot_size);
+    run->free_count = run->slot_count;
+    for (int w = 0; w < TINY_BITMAP_WORDS; w++) {
+        int bits = run->slot_count - w * 64;
+        run->bitmap[w] = bits >= 64 ? ~0ULL : bits > 0 ? (1ULL << bits) - 1 : 0;
+    }
+    tiny_partial_insert(h, cls, run);
+    return run;
+}
+
+// 把整页 run 还给堆（调用者持有类锁，run 已移出可用链表）
+static void tiny_run_release(heap_t *h, tiny_run *run) {
+    size_t page = tiny_page(h, run);
+    heap_lock(h);
+    __atomic_fetch_and(&h->tiny_map[page / 32], ~(1U << (page % 32)), __ATOMIC_RELAXED);
+    release_block(h, (block_meta *)((char *)run - META_SIZE));
+    heap_unlock(h);
+}
+
+// 取一个空槽（调用者持有类锁）
+static void *tiny_take(heap_t *h, int cls) {
+    tiny_run *run = h->tiny_partial[cls];
+    if (run == NULL) {
+        run = tiny_run_create(h, cls);
+        if (run == NULL) {
+            return NULL;
+        }
+    }
+
+    int w = 0;
+    while (run->bitmap[w] == 0) {
+        w++;
+    }
+    int slot = w * 64 + __builtin_ctzll(run->bitmap[w]);
+    run->bitmap[w] &= run->bitmap[w] - 1;
+    if (--run->free_count == 0) {
+        tiny_partial_remove(h, cls, run);
+    }
+    return (char *)run + TINY_HEADER_SIZE + (size_t)slot * run->slot_size;
+}
+
+// 归还一个槽（调用者持有类锁）。run 变空且同类还有其他可用 run 时整页还给堆，
+// 每类保留一个空 run 避免在边界上反复申请和归还
+static void tiny_put(heap_t *h, int cls, void *ptr) {
+    tiny_run *run = tiny_run_of(ptr);
+    // 槽号 = 偏移 / slot_size，偏移不超过一页，用乘法代替除法
+    uint32_t units = (uint32_t)((char *)ptr - (char *)run - TINY_HEADER_SIZE) / ALIGNMENT;
+    size_t slot = (units * run->slot_reciprocal) >> 16;
+    run->bitmap[slot / 64] |= 1ULL << (slot % 64);
+
+    if (run->free_count++ == 0) {
+        tiny_partial_insert(h, cls, run);
+    } else if (run->free_count == run->slot_count &&
+               (h->tiny_partial[cls] != run || run->next != NULL)) {
+        tiny_partial_remove(h, cls, run);
+        tiny_run_release(h, run);
+    }
+}
+
+static void tiny_release(heap_t *h, void *ptr) {
+    int cls = tiny_class(tiny_run_of(ptr)->slot_size);
+    mutex_lock(&h->tiny_locks[cls]);
+    tiny_put(h, cls, ptr);
+    mutex_unlock(&h->tiny_locks[cls]);
+}
+
+// 归还所有空 run，供分配失败时回收（调用者不持有堆锁）
+static void tiny_trim(heap_t *h) {
+    for (int cls = 0; cls < TINY_CLASSES; cls++) {
+        mutex_lock(&h->tiny_locks[cls]);
+        tiny_run *run = h->tiny_partial[cls];
+        while (run != NULL) {
+            tiny_run *next = run->next;
+            if (run->free_count == run->slot_count) {
+                tiny_partial_remove(h, cls, run);
+                tiny_run_release(h, run);
+            }
+            run = next;
+        }
+        mutex_unlock(&h->tiny_locks[cls]);
+    }
+}
+#else
+static void tiny_trim(heap_t *h) {
+    (void)h;
+}
+#endif // ARM_MALLOC_TINY
+
+#if ARM_MALLOC_THREAD_SAFE
+// ---------------------------------------------------------------------------
+// 快速箱（quick bin）：每个堆的每个小块大小类一个无锁栈，位于线程缓存与共享堆之间。
+// 不同大小的并发分配只访问各自的栈，互不争用，也不进入共享堆锁。
+// 栈中的块在共享堆看来仍处于占用状态，数量受 QBIN_LIMIT 约束，
+// 共享堆分配失败时全部归还以便合并。
+// AArch64 上用 LDAXR/STLXR 实现：独占监视器在栈顶被改写时令 STXR 失败，
+// 天然没有 ABA 问题。主机上栈顶保存为“版本号 + 块偏移”的 64 位字，
+// 用 CAS 更新，版本号避免 ABA。
+// ---------------------------------------------------------------------------
+#if defined(__aarch64__)
+static void qbin_push(heap_t *h, qbin_t *bin, block_meta *block) {
+    block_meta *head, *current;
+    uint32_t fail;
+    (void)h;
+    // 先写好 block->next 再用独占对比较并发布，独占区间内不做其他存储
+    __asm__ volatile(
+        "1: ldr     %0, [%3]\n"
+        "   str     %0, [%4, %5]\n"
+        "   ldxr    %1, [%3]\n"
+        "   cmp     %1, %0\n"
+        "   b.ne    1b\n"
+        "   stlxr   %w2, %4, [%3]\n"
+        "   cbnz    %w2, 1b\n"
+        : "=&r"(head), "=&r"(current), "=&r"(fail)
+        : "r"(&bin->head), "r"(block), "i"(offsetof(block_meta, next))
+        : "cc", "memory");
+}
+
+static block_meta *qbin_pop(heap_t *h, qbin_t *bin) {
+    block_meta *head, *next;
+    uint32_t fail;
+    (void)h;
+    __asm__ volatile(
+        "1: ldaxr   %0, [%3]\n"
+        "   cbz     %0, 2f\n"
+        "   ldr     %1, [%0, %4]\n"
+        "   stxr    %w2, %1, [%3]\n"
+        "   cbnz    %w2, 1b\n"
+        "   b       3f\n"
+        "2: clrex\n"
+        "3:\n"
+        : "=&r"(head), "=&r"(next), "=&r"(fail)
+        : "r"(&bin->head), "i"(offsetof(block_meta, next))
+        : "memory");
+    return head;
+}
+#else
+static inline uint32_t qbin_encode(heap_t *h, block_meta *block) {
+    return block != NULL ? (uint32_t)(((char *)block - h->start) / ALIGNMENT + 1) : 0;
+}
+
+static inline block_meta *qbin_decode(heap_t *h, uint64_t head) {
+    uint32_t offset = (uint32_t)head;
+    return offset != 0 ? (block_meta *)(h->start + (size_t)(offset - 1) * ALIGNMENT) : NULL;
+}
+
+static void qbin_push(heap_t *h, qbin_t *bin, block_meta *block) {
+    uint64_t head = __atomic_load_n(&bin->head, __ATOMIC_RELAXED);
+    uint64_t desired;
+    do {
+        block->next = qbin_decode(h, head);
+        desired = (((head >> 32) + 1) << 32) | qbin_encode(h, block);
+    } while (!__atomic_compare_exchange_n(&bin->head, &head, desired, 1,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+static block_meta *qbin_pop(heap_t *h, qbin_t *bin) {
+    uint64_t head = __atomic_load_n(&bin->head, __ATOMIC_ACQUIRE);
+    uint64_t desired;
+    block_meta *block;
+    do {
+        block = qbin_decode(h, head);
+        if (block == NULL) {
+            return NULL;
+        }
+        // 栈顶若已被其他线程取走，读到的 next 可能过期，但版本号会让 CAS 失败
+        desired = (((head >> 32) + 1) << 32) | qbin_encode(h, block->next);
+    } while (!__atomic_compare_exchange_n(&bin->head, &head, desired, 1,
+                                          __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+    return block;
+}
+#endif
+
+// 归还所有快速箱中的块（调用者持有堆锁）
+static void qbin_flush_all(heap_t *h) {
+    for (int cls = 0; cls < NUM_SMALL_CLASSES; cls++) {
+        block_meta *block;
+        while ((block = qbin_pop(h, &h->qbins[cls])) != NULL) {
+            __atomic_fetch_sub(&h->qbins[cls].count, 1, __ATOMIC_RELAXED);
+            release_block(h, block);
+        }
+    }
+}
+
+// 从共享层取一个小块：先查无锁快速箱，再加锁访问共享堆
+static block_meta *shared_alloc_small(heap_t *h, size_t aligned_size) {
+    qbin_t *bin = &h->qbins[small_class(aligned_size)];
+    block_meta *block = qbin_pop(h, bin);
+    if (block != NULL) {
+        __atomic_fetch_sub(&bin->count, 1, __ATOMIC_RELAXED);
+        return block;
+    }
+
+    heap_lock(h);
+    block = alloc_block(h, aligned_size);
+    heap_unlock(h);
+    return block;
+}
+
+// 把一个小块还给共享层：快速箱未满时无锁入栈。
+// 未被分割的块可能略大于 SMALL_MAX_SIZE，这类块直接还给共享堆
+static void shared_free_small(heap_t *h, block_meta *block) {
+    size_t size = block_size(block);
+    if (size <= SMALL_MAX_SIZE) {
+        qbin_t *bin = &h->qbins[small_class(size)];
+        if (__atomic_load_n(&bin->count, __ATOMIC_RELAXED) < QBIN_LIMIT) {
+            __atomic_fetch_add(&bin->count, 1, __ATOMIC_RELAXED);
+            qbin_push(h, bin, block);
+            return;
+        }
+    }
+
+    heap_lock(h);
+    release_block(h, block);
+    heap_unlock(h);
+}
+#else
+static void qbin_flush_all(heap_t *h) {
+    (void)h;
+}
+
+static block_meta *shared_alloc_small(heap_t *h, size_t aligned_size) {
+    return alloc_block(h, aligned_size);
+}
+
+static void shared_free_small(heap_t *h, block_meta *block) {
+    release_block(h, block);
+}
+#endif // ARM_MALLOC_THREAD_SAFE
+
+// ---------------------------------------------------------------------------
+// 每线程（裸机上为每核）状态：每个堆一份线程缓存与统计计数器。只由所属线程写入，
+// 热路径上不加锁、不使用原子操作；查询统计时再把各线程的计数汇总。
+// ---------------------------------------------------------------------------
+typedef struct {
+    size_t bytes_allocated;                    // 累计分配的块负载字节
+    size_t bytes_freed;                        // 累计释放的块负载字节
+    unsigned long alloc_count;
+    unsigned long free_count;
+    unsigned long failed_count;
+    unsigned long realloc_in_place;
+    unsigned long realloc_moved;
+    unsigned long histogram[ARM_MALLOC_HIST_BINS];  // 请求大小按 log2 分桶
+} thread_stats;
+
+#if ARM_MALLOC_TCACHE
+// 线程缓存（magazine）：按精确大小类缓存最近释放的小块，命中时不加锁、
+// 不使用原子操作。缓存的块在共享堆看来仍处于占用状态，通过块头中闲置的
+// next 指针串成单链表。缓存为空或已满时，以 TCACHE_BATCH 为单位与共享层交换。
+#define TCACHE_MAG_SIZE    32                           // 每个大小类最多缓存的块数
+#define TCACHE_BATCH       16                           // 与共享层批量交换的块数
+
+typedef struct {
+    int count[NUM_SMALL_CLASSES];
+    block_meta *head[NUM_SMALL_CLASSES];
+#if ARM_MALLOC_TINY
+    int tiny_count[TINY_CLASSES];
+    void *tiny_head[TINY_CLASSES];             // 对象首字存放链表指针
+#endif
+} tcache_t;
+
+static int tcache_enabled = 1;
+#endif
+
+// 线程在某个堆上的私有状态，generation 与堆不一致时整体作废
+typedef struct {
+    unsigned generation;                       // 所属堆的创建代数
+#if ARM_MALLOC_TCACHE
+    tcache_t tcache;
+#endif
+    thread_stats stats;
+} heap_local;
+
+typedef struct thread_state {
+    heap_local heaps[ARM_MALLOC_MAX_HEAPS];    // 与 heaps[] 一一对应
+#if defined(__linux__)
+    int registered;                            // 已加入线程链表并注册退出回调
+    struct thread_state *next;
+    struct thread_state *prev;
+#endif
+} thread_state;
+
+#if defined(__linux__)
+static __thread thread_state thread_local_state;
+static thread_state *thread_states = NULL;      // 所有活动线程（持有 registry_mutex 访问）
+static thread_stats retired_stats[ARM_MALLOC_MAX_HEAPS];  // 已退出线程的计数
+static pthread_key_t thread_state_key;
+static pthread_once_t thread_state_key_once = PTHREAD_ONCE_INIT;
+
+static void thread_state_exit(void *arg);
+
+static void thread_state_create_key(void) {
+    pthread_key_create(&thread_state_key, thread_state_exit);
+}
+
+static inline thread_state *thread_state_get(void) {
+    return &thread_local_state;
+}
+
+static void retired_stats_reset(int index) {
+    memset(&retired_stats[index], 0, sizeof(retired_stats[index]));
+}
+#elif defined(__aarch64__)
+// 裸机：按 MPIDR_EL1.Aff0 区分核。同一核上的中断处理程序不得与线程级代码
+// 并发使用分配器
+#define NUM_THREAD_STATES ARM_MALLOC_MAX_CPUS
+static thread_state thread_states[NUM_THREAD_STATES];
+
+static inline thread_state *thread_state_get(void) {
+    uint64_t mpidr;
+    __asm__ volatile("mrs %0, mpidr_el1" : "=r"(mpidr));
+    return &thread_states[(mpidr & 0xff) % NUM_THREAD_STATES];
+}
+
+static void retired_stats_reset(int index) {
+    (void)index;
+}
+#else
+#define NUM_THREAD_STATES 1
+static thread_state thread_states[NUM_THREAD_STATES];
+
+static inline thread_state *thread_state_get(void) {
+    return &thread_states[0];
+}
+
+static void retired_stats_reset(int index) {
+    (void)index;
+}
+#endif
+
+// 首次使用或堆被重新创建后的准备：旧堆中的缓存块和计数直接丢弃
+static void thread_state_setup(thread_state *state, heap_local *local, heap_t *h) {
+    if (local->generation != h->generation) {
+#if ARM_MALLOC_TCACHE
+        memset(&local->tcache, 0, sizeof(local->tcache));
+#endif
+        memset(&local->stats, 0, sizeof(local->stats));
+        local->generation = h->generation;
+    }
+#if defined(__linux__)
+    if (!state->registered) {
+        pthread_once(&thread_state_key_once, thread_state_create_key);
+        pthread_setspecific(thread_state_key, state);
+
+        mutex_lock(&registry_mutex);
+        state->prev = NULL;
+        state->next = thread_states;
+        if (thread_states != NULL) {
+            thread_states->prev = state;
+        }
+        thread_states = state;
+        mutex_unlock(&registry_mutex);
+        state->registered = 1;
+    }
+#else
+    (void)state;
+#endif
+}
+
+// 取得当前线程在堆 h 上的状态，热路径上只有一次比较
+static inline heap_local *heap_local_acquire(heap_t *h) {
+    thread_state *state = thread_state_get();
+    heap_local *local = &state->heaps[h->index];
+#if defined(__linux__)
+    if (__builtin_expect(local->generation != h->generation || !state->registered, 0)) {
+#else
+    if (__builtin_expect(local->generation != h->generation, 0)) {
+#endif
+        thread_state_setup(state, local, h);
+    }
+    return local;
+}
+
+static inline void stats_add(thread_stats *total, const thread_stats *stats) {
+    total->bytes_allocated += stats->bytes_allocated;
+    total->bytes_freed += stats->bytes_freed;
+    total->alloc_count += stats->alloc_count;
+    total->free_count += stats->free_count;
+    total->failed_count += stats->failed_count;
+    total->realloc_in_place += stats->realloc_in_place;
+    total->realloc_moved += stats->realloc_moved;
+    for (int i = 0; i < ARM_MALLOC_HIST_BINS; i++) {
+        total->histogram[i] += stats->histogram[i];
+    }
+}
+
+// granted 为实际交给调用者的字节数，0 表示失败
+static inline void stats_record_alloc_size(heap_local *local, size_t request, size_t granted) {
+    int bin = arm_fls(request);
+    local->stats.histogram[bin < ARM_MALLOC_HIST_BINS ? bin : ARM_MALLOC_HIST_BINS - 1]++;
+    if (granted != 0) {
+        local->stats.alloc_count++;
+        local->stats.bytes_allocated += granted;
+    } else {
+        local->stats.failed_count++;
+    }
+}
+
+static inline void stats_record_alloc(heap_local *local, size_t request, block_meta *block) {
+    stats_record_alloc_size(local, request, block != NULL ? block_size(block) : 0);
+}
+
+static inline void stats_record_free(heap_local *local, size_t size) {
+    local->stats.free_count++;
+    local->stats.bytes_freed += size;
+}
+
+#if ARM_MALLOC_TCACHE
+// 把一个大小类中的 n 个块还给共享层
+static void tcache_drain(heap_t *h, tcache_t *cache, int cls, int n) {
+    while (n-- > 0 && cache->head[cls] != NULL) {
+        block_meta *block = cache->head[cls];
+        cache->head[cls] = block->next;
+        cache->count[cls]--;
+        shared_free_small(h, block);
+    }
+}
+
+#if ARM_MALLOC_TINY
+// 把一个微小对象大小类中的 n 个对象还给所在的 run
+static void tcache_tiny_drain(heap_t *h, tcache_t *cache, int cls, int n) {
+    mutex_lock(&h->tiny_locks[cls]);
+    while (n-- > 0 && cache->tiny_head[cls] != NULL) {
+        void *ptr = cache->tiny_head[cls];
+        cache->tiny_head[cls] = *(void **)ptr;
+        cache->tiny_count[cls]--;
+        tiny_put(h, cls, ptr);
+    }
+    mutex_unlock(&h->tiny_locks[cls]);
+}
+#endif
+
+// 归还缓存中的全部块
+static void tcache_flush_all(heap_t *h, tcache_t *cache) {
+    for (int cls = 0; cls < NUM_SMALL_CLASSES; cls++) {
+        if (cache->count[cls] > 0) {
+            tcache_drain(h, cache, cls, cache->count[cls]);
+        }
+    }
+#if ARM_MALLOC_TINY
+    for (int cls = 0; cls < TINY_CLASSES; cls++) {
+        if (cache->tiny_count[cls] > 0) {
+            tcache_tiny_drain(h, cache, cls, cache->tiny_count[cls]);
+        }
+    }
+#endif
+}
+
+static block_meta *tcache_pop(heap_t *h, tcache_t *cache, size_t aligned_size) {
+    int cls = small_class(aligned_size);
+
+    if (cache->head[cls] == NULL) {
+        // 缓存为空，从共享层批量补充
+        for (int i = 0; i < TCACHE_BATCH; i++) {
+            block_meta *block = shared_alloc_small(h, aligned_size);
+            if (block == NULL) {
+                break;
+            }
+            block->next = cache->head[cls];
+            cache->head[cls] = block;
+            cache->count[cls]++;
+        }
+
+        if (cache->head[cls] == NULL) {
+            return NULL;
+        }
+    }
+
+    block_meta *block = cache->head[cls];
+    cache->head[cls] = block->next;
+    cache->count[cls]--;
+    return block;
+}
+
+static int tcache_push(heap_t *h, tcache_t *cache, block_meta *block) {
+    size_t size = block_size(block);
+    if (size > SMALL_MAX_SIZE) {
+        return 0;
+    }
+
+    int cls = small_class(size);
+    if (cache->count[cls] >= TCACHE_MAG_SIZE) {
+        // 缓存已满，先把一批块还给共享层
+        tcache_drain(h, cache, cls, TCACHE_BATCH);
+    }
+
+    block->next = cache->head[cls];
+    cache->head[cls] = block;
+    cache->count[cls]++;
+    return 1;
+}
+
+// 归还当前线程在堆 h 上缓存的块
+static void tcache_flush_heap(heap_t *h) {
+    heap_local *local = &thread_state_get()->heaps[h->index];
+    if (local->generation == h->generation) {
+        tcache_flush_all(h, &local->tcache);
+    }
+}
+
+void arm_malloc_tcache_enable(int enable) {
+    tcache_enabled = enable;
+}
+
+void arm_malloc_tcache_flush(void) {
+    for (int i = 0; i < ARM_MALLOC_MAX_HEAPS; i++) {
+        if (heaps[i] != NULL) {
+            tcache_flush_heap(heaps[i]);
+        }
+    }
+}
+#else
+static void tcache_flush_heap(heap_t *h) {
+    (void)h;
+}
+
+void arm_malloc_tcache_enable(int enable) {
+    (void)enable;
+}
+
+void arm_malloc_tcache_flush(void) {
+}
+#endif // ARM_MALLOC_TCACHE
+
+#if defined(__linux__)
+// 线程退出时归还全部缓存块，并把计数并入 retired_stats
+static void thread_state_exit(void *arg) {
+    thread_state *state = (thread_state *)arg;
+    int current[ARM_MALLOC_MAX_HEAPS];
+    for (int i = 0; i < ARM_MALLOC_MAX_HEAPS; i++) {
+        heap_t *h = heaps[i];
+        current[i] = h != NULL && state->heaps[i].generation == h->generation;
+#if ARM_MALLOC_TCACHE
+        if (current[i]) {
+            tcache_flush_all(h, &state->heaps[i].tcache);
+        }
+#endif
+    }
+
+    mutex_lock(&registry_mutex);
+    for (int i = 0; i < ARM_MALLOC_MAX_HEAPS; i++) {
+        if (current[i]) {
+            stats_add(&retired_stats[i], &state->heaps[i].stats);
+        }
+    }
+    if (state->prev != NULL) {
+        state->prev->next = state->next;
+    } else {
+        thread_states = state->next;
+    }
+    if (state->next != NULL) {
+        state->next->prev = state->prev;
+    }
+    mutex_unlock(&registry_mutex);
+    state->registered = 0;
+}
+#endif
+
+// 共享堆分配失败后的回收：归还本线程缓存、快速箱和延迟队列中暂存的块以及空闲的
+// 微小对象 run，让它们参与合并（调用者不持有堆锁）
+static void reclaim_caches(heap_t *h) {
+    tcache_flush_heap(h);
+    tiny_trim(h);
+
+    heap_lock(h);
+    qbin_flush_all(h);
+    defer_flush(h);
+    heap_unlock(h);
+}
+
+void heap_maintenance(heap_t *h) {
+    if (h != NULL) {
+        reclaim_caches(h);
+    }
+}
+
+void arm_malloc_maintenance(void) {
+    heap_maintenance(default_heap);
+}
+
+static block_meta *alloc_block_reclaim(heap_t *h, size_t aligned_size) {
+    reclaim_caches(h);
+
+    heap_lock(h);
+    block_meta *block = alloc_block(h, aligned_size);
+    heap_unlock(h);
+    return block;
+}
+
+#if ARM_MALLOC_TINY
+// 微小对象分配：线程缓存为空时在类锁下从 run 中批量补充
+static void *tiny_alloc(heap_t *h, heap_local *local, size_t size) {
+    int cls = tiny_class(size);
+    void *ptr;
+#if ARM_MALLOC_TCACHE
+    if (tcache_enabled) {
+        tcache_t *cache = &local->tcache;
+        if (cache->tiny_head[cls] == NULL) {
+            mutex_lock(&h->tiny_locks[cls]);
+            for (int i = 0; i < TCACHE_BATCH; i++) {
+                void *slot = tiny_take(h, cls);
+                if (slot == NULL) {
+                    break;
+                }
+                *(void **)slot = cache->tiny_head[cls];
+                cache->tiny_head[cls] = slot;
+                cache->tiny_count[cls]++;
+            }
+            mutex_unlock(&h->tiny_locks[cls]);
+
+            if (cache->tiny_head[cls] == NULL) {
+                return NULL;
+            }
+        }
+
+        ptr = cache->tiny_head[cls];
+        cache->tiny_head[cls] = *(void **)ptr;
+        cache->tiny_count[cls]--;
+        stats_record_alloc_size(local, size, (size_t)(cls + 1) * ALIGNMENT);
+        return ptr;
+    }
+#endif
+    mutex_lock(&h->tiny_locks[cls]);
+    ptr = tiny_take(h, cls);
+    mutex_unlock(&h->tiny_locks[cls]);
+    if (ptr != NULL) {
+        stats_record_alloc_size(local, size, (size_t)(cls + 1) * ALIGNMENT);
+    }
+    return ptr;
+}
+
+static void tiny_free(heap_t *h, heap_local *local, void *ptr) {
+    size_t slot_size = tiny_run_of(ptr)->slot_size;
+    stats_record_free(local, slot_size);
+#if ARM_MALLOC_TCACHE
+    if (tcache_enabled) {
+        tcache_t *cache = &local->tcache;
+        int cls = tiny_class(slot_size);
+        if (cache->tiny_count[cls] >= TCACHE_MAG_SIZE) {
+            tcache_tiny_drain(h, cache, cls, TCACHE_BATCH);
+        }
+        *(void **)ptr = cache->tiny_head[cls];
+        cache->tiny_head[cls] = ptr;
+        cache->tiny_count[cls]++;
+        return;
+    }
+#endif
+    tiny_release(h, ptr);
+}
+#endif // ARM_MALLOC_TINY
+
+// 在单个堆上分配，不考虑回退
+static inline block_meta *heap_alloc_block(heap_t *h, heap_local *local, size_t size) {
+    if (size > h->size) {
+        stats_record_alloc(local, size, NULL);
+        return NULL;
+    }
+
+    // 换算为对齐后的负载大小
+    size_t aligned_size = payload_size(size);
+    block_meta *block;
+
+    if (aligned_size <= SMALL_MAX_SIZE) {
+#if ARM_MALLOC_TCACHE
+        block = tcache_enabled ? tcache_pop(h, &local->tcache, aligned_size) : shared_alloc_small(h, aligned_size);
+#else
+        block = shared_alloc_small(h, aligned_size);
+#endif
+    } else {
+        heap_lock(h);
+        block = defer_take(h, aligned_size);
+        if (block == NULL) {
+            block = alloc_block(h, aligned_size);
+        }
+        heap_unlock(h);
+    }
+
+    if (block == NULL) {
+        block = alloc_block_reclaim(h, aligned_size);
+    }
+    stats_record_alloc(local, size, block);
+    return block;
+}
+
+// 依次尝试 h 及其回退链上的堆
+void *heap_malloc(heap_t *h, size_t size) {
+    if (size == 0) {
+        return NULL;
+    }
+
+    for (; h != NULL; h = h->fallback) {
+        heap_local *local = heap_local_acquire(h);
+#if ARM_MALLOC_TINY
+        if (size <= TINY_MAX_SIZE) {
+            // 没有空页建新 run 时仍可从普通块中分配
+            void *ptr = tiny_alloc(h, local, size);
+            if (ptr != NULL) {
+                return ptr;
+            }
+        }
+#endif
+        block_meta *block = heap_alloc_block(h, local, size);
+        if (block != NULL) {
+            // 返回块的数据部分（跳过元数据）
+            return (void *)((char *)block + META_SIZE);
         }
     }
+    return NULL;
 }
 
-// 寻找合适的空闲块（首次适应算法）
-static block_meta *find_free_block(size_t size) {
-    block_meta *current = free_list;
-    block_meta *best = NULL;
-    
-    // 使用首次适应算法
-    while (current != NULL) {
-        if (current->free && current->size >= size) {
-            // 如果找到合适的块，分割它
-            split_block(current, size);
-            current->free = 0;
-            return current;
+// 按地址找到所属的堆并释放，不属于任何堆的指针被忽略
+void heap_free(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+
+    heap_t *h = heap_from_ptr(ptr);
+    if (h == NULL) {
+        return;
+    }
+
+    heap_local *local = heap_local_acquire(h);
+#if ARM_MALLOC_TINY
+    if (tiny_owns(h, ptr)) {
+        tiny_free(h, local, ptr);
+        return;
+    }
+#endif
+
+    // 获取块的元数据
+    block_meta *block = (block_meta *)((char *)ptr - META_SIZE);
+    size_t size = block_size(block);
+    stats_record_free(local, size);
+
+    if (size <= SMALL_MAX_SIZE) {
+#if ARM_MALLOC_TCACHE
+        if (tcache_enabled && tcache_push(h, &local->tcache, block)) {
+            return;
         }
-        current = current->next;
+#endif
+        shared_free_small(h, block);
+        return;
     }
-    
-    return NULL; // 没有找到合适的块
+
+    heap_lock(h);
+    defer_free(h, block);
+    heap_unlock(h);
+}
+
+// malloc 实现
+void *arm_malloc(size_t size) {
+    return heap_malloc(default_heap, size);
+}
+
+// free 实现
+void arm_free(void *ptr) {
+    heap_free(ptr);
 }
 
-// 定义不同大小的内存桶
-#define NUM_BUCKETS 10
-static block_meta *free_buckets[NUM_BUCKETS] = {NULL};
+// 取出容纳 n 个块的区域并写好全部块头。首块已在堆中，相邻块的释放会在锁内
+// 修改它的状态位，因此切分必须在释放锁之前完成
+static block_meta *batch_take(heap_t *h, size_t total, size_t n, size_t aligned_size) {
+    size_t stride = META_SIZE + aligned_size;
 
-// 根据大小确定桶索引
-static int get_bucket_index(size_t size) {
-    int index = 0;
-    size_t min_size = 16; // 最小块大小
-    
-    while (min_size < size && index < NUM_BUCKETS - 1) {
-        min_size *= 2;
-        index++;
+    heap_lock(h);
+    block_meta *block = alloc_block(h, total);
+    if (block != NULL) {
+        // 最后一块吸收 split_block 未能切下的零头
+        size_t last_size = block_size(block) - (n - 1) * stride;
+        block_set_size(block, aligned_size);  // 保留首块的状态位
+        for (size_t i = 1; i < n; i++) {
+            block_meta *current = (block_meta *)((char *)block + i * stride);
+            current->size = i + 1 < n ? aligned_size : last_size;
+        }
     }
-    
-    return index;
+    heap_unlock(h);
+    return block;
 }
 
-// 优化后的查找函数
-static block_meta *find_free_block_optimized(size_t size) {
-    int bucket_index = get_bucket_index(size);
-    
-    // 在当前及更大的桶中查找
-    for (int i = bucket_index; i < NUM_BUCKETS; i++) {
-        block_meta *current = free_buckets[i];
-        while (current != NULL) {
-            if (current->free && current->size >= size) {
-                // 从原桶中移除
-                if (current->prev != NULL) {
-                    current->prev->next = current->next;
-                } else {
-                    free_buckets[i] = current->next;
-                }
-                if (current->next != NULL) {
-                    current->next->prev = current->prev;
-                }
-                
-                // 分割块
-                split_block(current, size);
-                current->free = 0;
-                
-                // 将剩余部分放回合适的桶
-                if (current->next != NULL && current->next->free) {
-                    block_meta *remaining = current->next;
-                    int rem_bucket = get_bucket_index(remaining->size);
-                    remaining->next = free_buckets[rem_bucket];
-                    if (free_buckets[rem_bucket] != NULL) {
-                        free_buckets[rem_bucket]->prev = remaining;
-                    }
-                    remaining->prev = NULL;
-                    free_buckets[rem_bucket] = remaining;
-                }
-                
-                return current;
+// 批量分配：一次查找取出能容纳 n 个块的连续区域，再在其中逐个切分，
+// 各块之间不留空隙，也不再逐个进入空闲索引。找不到足够大的区域时
+// 退回逐个分配（仍沿回退链）。返回成功分配的块数，其余 out[] 置为 NULL
+size_t heap_malloc_batch(heap_t *h, size_t size, size_t n, void **out) {
+    size_t done = 0;
+    if (size == 0 || h == NULL) {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = NULL;
+        }
+        return 0;
+    }
+
+    size_t aligned_size = payload_size(size);
+    size_t stride = META_SIZE + aligned_size;
+    if (n > 1 && size <= h->size && n <= h->size / stride) {
+        size_t total = n * stride - META_SIZE;
+
+        block_meta *block = batch_take(h, total, n, aligned_size);
+        if (block == NULL) {
+            reclaim_caches(h);
+            block = batch_take(h, total, n, aligned_size);
+        }
+
+        if (block != NULL) {
+            heap_local *local = heap_local_acquire(h);
+            for (size_t i = 0; i < n; i++) {
+                block_meta *current = (block_meta *)((char *)block + i * stride);
+                stats_record_alloc(local, size, current);
+                out[i] = (void *)((char *)current + META_SIZE);
             }
-            current = current->next;
+            return n;
         }
     }
-    
-    return NULL; // 没有找到合适的块
+
+    for (; done < n; done++) {
+        out[done] = heap_malloc(h, size);
+        if (out[done] == NULL) {
+            break;
+        }
+    }
+    for (size_t i = done; i < n; i++) {
+        out[i] = NULL;
+    }
+    return done;
 }
 
-// malloc 实现
-void *arm_malloc(size_t size) {
-    if (size == 0 || heap_start == NULL) {
+size_t arm_malloc_batch(size_t size, size_t n, void **out) {
+    return heap_malloc_batch(default_heap, size, n, out);
+}
+
+// 按地址升序排列（希尔排序，不依赖 C 库）
+static void sort_by_address(void **ptrs, size_t n) {
+    size_t gap = 1;
+    while (gap < n / 3) {
+        gap = gap * 3 + 1;
+    }
+    for (; gap > 0; gap /= 3) {
+        for (size_t i = gap; i < n; i++) {
+            void *p = ptrs[i];
+            size_t j = i;
+            while (j >= gap && (uintptr_t)ptrs[j - gap] > (uintptr_t)p) {
+                ptrs[j] = ptrs[j - gap];
+                j -= gap;
+            }
+            ptrs[j] = p;
+        }
+    }
+}
+
+// 批量释放：按地址排序后，物理相邻的块先直接拼成一个占用块，
+// 每段连续区间只与两侧空闲块合并一次。绕过线程缓存，直接还给共享堆。
+// ptrs 数组会被重新排序
+void heap_free_batch(void **ptrs, size_t n) {
+    sort_by_address(ptrs, n);
+
+    size_t i = 0;
+    while (i < n) {
+        heap_t *h = ptrs[i] != NULL ? heap_from_ptr(ptrs[i]) : NULL;
+        if (h == NULL) {
+            i++;
+            continue;
+        }
+
+        // 排序后属于同一个堆的指针连续排列
+        heap_local *local = heap_local_acquire(h);
+        heap_lock(h);
+        while (i < n && (char *)ptrs[i] < h->end) {
+#if ARM_MALLOC_TINY
+            if (tiny_owns(h, ptrs[i])) {
+                // 微小对象还给所在的 run；不能持有堆锁进入类锁
+                heap_unlock(h);
+                stats_record_free(local, tiny_run_of(ptrs[i])->slot_size);
+                tiny_release(h, ptrs[i++]);
+                heap_lock(h);
+                continue;
+            }
+#endif
+            block_meta *run = (block_meta *)((char *)ptrs[i] - META_SIZE);
+            stats_record_free(local, block_size(run));
+            i++;
+
+            // 微小对象不会紧跟在某个块之后（run 头部占据页首），相邻判断不会误认
+            while (i < n && (char *)ptrs[i] < h->end &&
+                   (block_meta *)((char *)ptrs[i] - META_SIZE) == next_phys_block(h, run)) {
+                block_meta *next = (block_meta *)((char *)ptrs[i] - META_SIZE);
+                stats_record_free(local, block_size(next));
+                compact_forget(h, next);
+                block_set_size(run, block_size(run) + META_SIZE + block_size(next));
+                i++;
+            }
+            release_block(h, run);
+        }
+        heap_unlock(h);
+    }
+}
+
+void arm_free_batch(void **ptrs, size_t n) {
+    heap_free_batch(ptrs, n);
+}
+
+// calloc 取大块：在同一次持锁内读出写入高水位，*dirty 返回负载开头需要清零的字节数。
+// 空闲块的头部与链接都在高水位之下，高于它的部分仍是区域创建时的零
+static block_meta *calloc_block(heap_t *h, size_t aligned_size, size_t *dirty) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (attempt > 0) {
+            reclaim_caches(h);
+        }
+
+        heap_lock(h);
+        const char *clean = h->zeroed ? h->untouched : NULL;
+        block_meta *block = alloc_block(h, aligned_size);
+        heap_unlock(h);
+
+        if (block != NULL) {
+            const char *payload = (const char *)block + META_SIZE;
+            *dirty = clean == NULL ? SIZE_MAX : clean > payload ? (size_t)(clean - payload) : 0;
+            return block;
+        }
+    }
+    return NULL;
+}
+
+// 依次尝试 h 及其回退链上的堆；num * size 溢出时失败
+void *heap_calloc(heap_t *h, size_t num, size_t size) {
+    if (size != 0 && num > SIZE_MAX / size) {
         return NULL;
     }
-    
-    // 对齐请求的大小
-    size_t aligned_size = ALIGN(size);
-    
-    // 寻找合适的空闲块
-    block_meta *block = find_free_block(aligned_size);
-    if (block != NULL) {
-        // 返回块的数据部分（跳过元数据）
-        return (void *)((char *)block + META_SIZE);
+    size_t total = num * size;
+
+    // 小块来自线程缓存或快速箱，内容未知，直接清零
+    if (total == 0 || payload_size(total) <= SMALL_MAX_SIZE) {
+        void *ptr = heap_malloc(h, total);
+        if (ptr != NULL) {
+            memset(ptr, 0, total);
+        }
+        return ptr;
+    }
+
+    for (; h != NULL; h = h->fallback) {
+        heap_local *local = heap_local_acquire(h);
+        size_t dirty = 0;
+        block_meta *block = total <= h->size ? calloc_block(h, payload_size(total), &dirty) : NULL;
+        stats_record_alloc(local, total, block);
+        if (block != NULL) {
+            void *ptr = (char *)block + META_SIZE;
+            memset(ptr, 0, dirty < total ? dirty : total);
+            return ptr;
+        }
     }
-    
-    // 没有可用的空闲块
     return NULL;
 }
 
-// free 实现
-void arm_free(void *ptr) {
-    if (ptr == NULL || heap_start == NULL) {
-        return;
+void *arm_calloc(size_t num, size_t size) {
+    return heap_calloc(default_heap, num, size);
+}
+
+// 尝试原地调整块大小：缩小时切下尾部，扩大时吸收右侧相邻的空闲块（调用者持有堆锁）
+static int resize_in_place(heap_t *h, block_meta *block, size_t aligned_size) {
+    if (block_size(block) >= aligned_size) {
+        shrink_block(h, block, aligned_size);
+        return 1;
     }
-    
-    // 获取块的元数据
+
+    block_meta *next = next_phys_block(h, block);
+    if (next == NULL || !block_is_free(next) ||
+        block_size(block) + META_SIZE + block_size(next) < aligned_size) {
+        return 0;
+    }
+
+    free_list_remove(h, next);
+    block_set_size(block, block_size(block) + META_SIZE + block_size(next));
+    shrink_block(h, block, aligned_size);
+    mark_touched(h, block);
+    heap_update_peak(h);
+    return 1;
+}
+
+// 对齐分配：多找出 alignment + MIN_SPLIT_SIZE 字节再由 align_block 切出对齐部分，
+// 结果仍是普通块，可直接交给 arm_free/arm_realloc
+static block_meta *heap_memalign_block(heap_t *h, size_t alignment, size_t size) {
+    if (alignment <= ALIGNMENT) {
+        return heap_alloc_block(h, heap_local_acquire(h), size);
+    }
+    if (size > h->size || alignment > h->size) {
+        return NULL;
+    }
+
+    size_t aligned_size = payload_size(size);
+    size_t search_size = aligned_size + alignment + MIN_SPLIT_SIZE;
+
+    heap_lock(h);
+    block_meta *block = alloc_block(h, search_size);
+    if (block == NULL) {
+        heap_unlock(h);
+        block = alloc_block_reclaim(h, search_size);
+        if (block == NULL) {
+            stats_record_alloc(heap_local_acquire(h), size, NULL);
+            return NULL;
+        }
+        heap_lock(h);
+    }
+    block = align_block(h, block, alignment, aligned_size);
+    heap_unlock(h);
+
+    stats_record_alloc(heap_local_acquire(h), size, block);
+    return block;
+}
+
+void *heap_memalign(heap_t *h, size_t alignment, size_t size) {
+    if ((alignment & (alignment - 1)) != 0 || size == 0) {
+        return NULL;
+    }
+
+    for (; h != NULL; h = h->fallback) {
+        block_meta *block = heap_memalign_block(h, alignment, size);
+        if (block != NULL) {
+            return (void *)((char *)block + META_SIZE);
+        }
+    }
+    return NULL;
+}
+
+void *arm_memalign(size_t alignment, size_t size) {
+    return heap_memalign(default_heap, alignment, size);
+}
+
+void *arm_aligned_alloc(size_t alignment, size_t size) {
+    return arm_memalign(alignment, size);
+}
+
+// realloc 实现：先在所属的堆上原地调整，否则从所属的堆（及其回退链）重新分配
+// 原地调整：微小对象只能留在原槽内，普通块缩小或吸收右侧相邻的空闲块。
+// *usable 返回调整前调用者可用的字节数
+static int try_realloc_in_place(heap_t *h, heap_local *local, void *ptr, size_t size, size_t *usable) {
+#if ARM_MALLOC_TINY
+    if (tiny_owns(h, ptr)) {
+        *usable = tiny_run_of(ptr)->slot_size;
+        return size <= *usable;
+    }
+#endif
+
+    // 获取原有块的元数据（可用字节含借用的后继 prev_size 字段）
     block_meta *block = (block_meta *)((char *)ptr - META_SIZE);
-    
-    // 标记块为空闲
-    block->free = 1;
-    
-    // 将块添加到空闲链表
-    block->next = free_list;
-    free_list = block;
-    
-    // 尝试合并相邻的空闲块
-    coalesce_blocks();
-}
-
-// calloc 实现
-void *arm_calloc(size_t num, size_t size) {
-    size_t total_size = num * size;
-    void *ptr = arm_malloc(total_size);
-    if (ptr != NULL) {
-        // 将分配的内存清零
-        memset(ptr, 0, total_size);
+    size_t old_size = block_size(block);
+    *usable = old_size + HEADER_OVERLAP;
+    if (size > h->size) {
+        return 0;
     }
-    return ptr;
+
+    heap_lock(h);
+    int in_place = resize_in_place(h, block, payload_size(size));
+    heap_unlock(h);
+    if (in_place) {
+        local->stats.bytes_allocated += block_size(block);
+        local->stats.bytes_freed += old_size;
+    }
+    return in_place;
 }
 
-// realloc 实现
-void *arm_realloc(void *ptr, size_t size) {
+void *heap_realloc(void *ptr, size_t size) {
     if (ptr == NULL) {
         return arm_malloc(size);
     }
-    
+
     if (size == 0) {
-        arm_free(ptr);
+        heap_free(ptr);
         return NULL;
     }
-    
-    // 获取原有块的元数据
-    block_meta *block = (block_meta *)((char *)ptr - META_SIZE);
-    
-    // 如果原有块足够大，直接返回
-    if (block->size >= size) {
+
+    heap_t *h = heap_from_ptr(ptr);
+    if (h == NULL) {
+        return NULL;
+    }
+
+    // 优先原地缩小或扩大，避免复制
+    heap_local *local = heap_local_acquire(h);
+    size_t usable;
+    if (try_realloc_in_place(h, local, ptr, size, &usable)) {
+        local->stats.realloc_in_place++;
         return ptr;
     }
-    
+
     // 分配新内存
-    void *new_ptr = arm_malloc(size);
+    void *new_ptr = heap_malloc(h, size);
     if (new_ptr != NULL) {
         // 复制数据
-        memcpy(new_ptr, ptr, block->size);
+        memcpy(new_ptr, ptr, usable < size ? usable : size);
         // 释放旧内存
-        arm_free(ptr);
+        heap_free(ptr);
+        local->stats.realloc_moved++;
     }
-    
+
     return new_ptr;
 }
 
-// // 打印内存统计信息
-// void arm_malloc_stats() {
-//     size_t total_free = 0;
-//     int free_blocks = 0;
-//     block_meta *current = free_list;
-    
-//     while (current != NULL) {
-//         if (current->free) {
-//             total_free += current->size;
-//             free_blocks++;
-//         }
-//         current = current->next;
-//     }
-    
-//     // 打印统计信息
-//     printf("Heap stats:\n");
-//     printf("  Total heap size: %zu bytes\n", heap_size);
-//     printf("  Free memory: %zu bytes in %d blocks\n", total_free, free_blocks);
-//     printf("  Used memory: %zu bytes\n", heap_size - total_free);
-// }
\ No newline at end of file
+void *arm_realloc(void *ptr, size_t size) {
+    return heap_realloc(ptr, size);
+}
+
+#if ARM_MALLOC_HANDLES
+// ---------------------------------------------------------------------------
+// 句柄与增量整理：句柄块直接从共享堆取出并带 BLOCK_MOVABLE 标记，负载开头
+// ALIGNMENT 字节记录句柄槽号，供整理时由块找回句柄。调用者只通过 hlock 取得的
+// 指针访问数据，未锁定的块可以被搬移。句柄表分块同样带标记（记录分块号），
+// 每块约 2 KiB，也能在一个时间片内搬移。句柄表与锁计数都由堆锁保护
+// ---------------------------------------------------------------------------
+#define HANDLE_SLOT_BITS    24
+#define HANDLE_SLOT_MASK    ((1U << HANDLE_SLOT_BITS) - 1)
+#define HANDLE_CHUNK_TAG    0xFF000000U   // 标记高 8 位全 1 表示句柄表分块，低位为分块号
+
+static inline uint32_t *handle_tag(block_meta *block) {
+    return (uint32_t *)((char *)block + META_SIZE);
+}
+
+static inline handle_entry *handle_slot(heap_t *h, uint32_t slot) {
+    return &h->handle_chunks[slot / HANDLE_CHUNK_SLOTS][slot % HANDLE_CHUNK_SLOTS];
+}
+
+static inline arm_handle_t handle_encode(heap_t *h, uint32_t slot) {
+    return ((arm_handle_t)(h->index + 1) << HANDLE_SLOT_BITS) | (slot + 1);
+}
+
+// 句柄所属的堆，编号无效时返回 NULL
+static heap_t *handle_heap(arm_handle_t handle) {
+    uint32_t index = handle >> HANDLE_SLOT_BITS;
+    return index == 0 || index > ARM_MALLOC_MAX_HEAPS ? NULL : heaps[index - 1];
+}
+
+// 句柄对应的条目，已释放或越界时返回 NULL（调用者持有堆锁，分块可能被整理搬移）
+static handle_entry *handle_entry_of(heap_t *h, arm_handle_t handle) {
+    uint32_t slot = (handle & HANDLE_SLOT_MASK) - 1;
+    if (slot >= h->handle_chunk_count * HANDLE_CHUNK_SLOTS || handle_slot(h, slot)->block == NULL) {
+        return NULL;
+    }
+    return handle_slot(h, slot);
+}
+
+// 取一个空闲条目，没有时新增一个分块（调用者持有堆锁），失败返回 -1
+static int handle_slot_alloc(heap_t *h) {
+    if (h->handle_free == 0) {
+        uint32_t chunk = h->handle_chunk_count;
+        if (chunk == HANDLE_MAX_CHUNKS) {
+            return -1;
+        }
+        block_meta *block = alloc_block(h, payload_size(ALIGNMENT + HANDLE_CHUNK_SLOTS * sizeof(handle_entry)));
+        if (block == NULL) {
+            return -1;
+        }
+        block->size |= BLOCK_MOVABLE;
+        *handle_tag(block) = HANDLE_CHUNK_TAG | chunk;
+
+        handle_entry *entries = (handle_entry *)((char *)block + META_SIZE + ALIGNMENT);
+        uint32_t base = chunk * HANDLE_CHUNK_SLOTS;
+        for (uint32_t i = 0; i < HANDLE_CHUNK_SLOTS; i++) {
+            entries[i].block = NULL;
+            entries[i].lock_count = 0;
+            entries[i].next_free = i + 1 < HANDLE_CHUNK_SLOTS ? base + i + 2 : 0;
+        }
+        h->handle_chunks[chunk] = entries;
+        h->handle_chunk_count = chunk + 1;
+        h->handle_free = base + 1;
+    }
+
+    uint32_t slot = h->handle_free - 1;
+    h->handle_free = handle_slot(h, slot)->next_free;
+    return (int)slot;
+}
+
+static void handle_slot_release(heap_t *h, uint32_t slot) {
+    handle_entry *entry = handle_slot(h, slot);
+    entry->block = NULL;
+    entry->lock_count = 0;
+    entry->next_free = h->handle_free;
+    h->handle_free = slot + 1;
+}
+
+// 在单个堆上分配句柄块，不考虑回退
+static arm_handle_t heap_hmalloc_one(heap_t *h, size_t size) {
+    heap_local *local = heap_local_acquire(h);
+    if (size > h->size - ALIGNMENT) {
+        stats_record_alloc(local, size, NULL);
+        return 0;
+    }
+
+    size_t aligned_size = payload_size(size + ALIGNMENT);
+    arm_handle_t handle = 0;
+    size_t granted = 0;             // 解锁后块可能已被整理搬移，大小须在锁内读出
+    for (int attempt = 0; attempt < 2 && handle == 0; attempt++) {
+        if (attempt > 0) {
+            reclaim_caches(h);
+        }
+
+        heap_lock(h);
+        int slot = handle_slot_alloc(h);
+        if (slot >= 0) {
+            block_meta *block = alloc_block(h, aligned_size);
+            if (block != NULL) {
+                block->size |= BLOCK_MOVABLE;
+                granted = block_size(block);
+                *handle_tag(block) = (uint32_t)slot;
+                handle_slot(h, (uint32_t)slot)->block = block;
+                handle = handle_encode(h, (uint32_t)slot);
+            } else {
+                handle_slot_release(h, (uint32_t)slot);
+            }
+        }
+        heap_unlock(h);
+    }
+
+    stats_record_alloc_size(local, size, granted);
+    return handle;
+}
+
+arm_handle_t heap_hmalloc(heap_t *h, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+
+    for (; h != NULL; h = h->fallback) {
+        arm_handle_t handle = heap_hmalloc_one(h, size);
+        if (handle != 0) {
+            return handle;
+        }
+    }
+    return 0;
+}
+
+arm_handle_t hmalloc(size_t size) {
+    return heap_hmalloc(default_heap, size);
+}
+
+void hfree(arm_handle_t handle) {
+    heap_t *h = handle_heap(handle);
+    if (h == NULL) {
+        return;
+    }
+
+    heap_local *local = heap_local_acquire(h);
+    heap_lock(h);
+    handle_entry *entry = handle_entry_of(h, handle);
+    if (entry == NULL) {
+        heap_unlock(h);
+        return;
+    }
+    block_meta *block = entry->block;
+    stats_record_free(local, block_size(block));
+    block->size &= ~BLOCK_MOVABLE;
+    handle_slot_release(h, (handle & HANDLE_SLOT_MASK) - 1);
+    release_block(h, block);
+    heap_unlock(h);
+}
+
+void *hlock(arm_handle_t handle) {
+    heap_t *h = handle_heap(handle);
+    if (h == NULL) {
+        return NULL;
+    }
+
+    heap_lock(h);
+    handle_entry *entry = handle_entry_of(h, handle);
+    void *ptr = NULL;
+    if (entry != NULL) {
+        entry->lock_count++;
+        ptr = (char *)entry->block + META_SIZE + ALIGNMENT;
+    }
+    heap_unlock(h);
+    return ptr;
+}
+
+void hunlock(arm_handle_t handle) {
+    heap_t *h = handle_heap(handle);
+    if (h == NULL) {
+        return;
+    }
+
+    heap_lock(h);
+    handle_entry *entry = handle_entry_of(h, handle);
+    if (entry != NULL && entry->lock_count > 0) {
+        entry->lock_count--;
+    }
+    heap_unlock(h);
+}
+
+static inline int block_movable(heap_t *h, block_meta *block) {
+    if ((block->size & BLOCK_MOVABLE) == 0) {
+        return 0;
+    }
+    uint32_t tag = *handle_tag(block);
+    return (tag & HANDLE_CHUNK_TAG) == HANDLE_CHUNK_TAG || handle_slot(h, tag)->lock_count == 0;
+}
+
+// 把空闲块 gap 之后的句柄块 block 搬到 gap 处，空出的空间作为空闲块放在其后并与
+// 右侧合并，返回该空闲块（调用者持有堆锁）。gap 的前一块必然已占用，
+// 搬移后的块因此不带 BLOCK_PREV_FREE
+static block_meta *slide_block(heap_t *h, block_meta *gap, block_meta *block) {
+    size_t gap_size = block_size(gap);
+    size_t size = block_size(block);
+    free_list_remove(h, gap);
+
+    // 连同借用的后继 prev_size 一起搬移
+    memmove((char *)gap + META_SIZE, (char *)block + META_SIZE, size + HEADER_OVERLAP);
+    gap->size = size | BLOCK_MOVABLE;
+    uint32_t tag = *handle_tag(gap);
+    if ((tag & HANDLE_CHUNK_TAG) == HANDLE_CHUNK_TAG) {
+        h->handle_chunks[tag & ~HANDLE_CHUNK_TAG] = (handle_entry *)((char *)gap + META_SIZE + ALIGNMENT);
+    } else {
+        handle_slot(h, tag)->block = gap;
+    }
+
+    block_meta *hole = (block_meta *)((char *)gap + META_SIZE + size);
+    hole->size = gap_size;
+    release_block(h, hole);
+    return hole;
+}
+
+size_t heap_compact(heap_t *h, size_t budget) {
+    if (h == NULL) {
+        return 0;
+    }
+
+    size_t moved = 0, spent = 0;
+    heap_lock(h);
+    defer_flush(h);  // 队列中的块看似占用，会挡住搬移
+    block_meta *prev = NULL;
+    block_meta *block = h->compact_cursor != NULL ? h->compact_cursor : (block_meta *)h->start;
+    while (block != NULL && spent < budget) {
+        block_meta *next = next_phys_block(h, block);
+        if (next == NULL) {
+            block = NULL;  // 一轮结束，下次从头开始
+            break;
+        }
+
+        if (block_is_free(block) && block_size(next) <= budget && block_movable(h, next)) {
+            if (spent + block_size(next) > budget) {
+                break;     // 留到下次，先把时间片用在访问上
+            }
+            spent += block_size(next);
+            moved += block_size(next);
+            prev = block;  // 搬移后的句柄块就在原空闲块的位置
+            block = slide_block(h, block, next);
+            continue;
+        }
+
+        spent += META_SIZE;
+        prev = block;
+        block = next;
+    }
+
+    // 游标只停在已占用块上，空闲块可能在下次调用前被合并掉。
+    // 空闲块的前一块必然已占用；位于堆首的空闲块则从头开始
+    h->compact_cursor = block != NULL && block_is_free(block) ? prev : block;
+    heap_unlock(h);
+    return moved;
+}
+
+size_t arm_malloc_compact(size_t budget) {
+    return heap_compact(default_heap, budget);
+}
+#endif // ARM_MALLOC_HANDLES
+
+// 最大空闲块：只在查询时计算，直接定位到索引中最大的非空链表
+static size_t largest_free_block(heap_t *h) {
+    block_meta *list;
+    switch (h->mode) {
+    case ARM_MALLOC_TLSF:
+        if (h->fl_bitmap == 0) {
+            return 0;
+        }
+        list = h->tlsf_blocks[arm_fls(h->fl_bitmap)][arm_fls(h->sl_bitmap[arm_fls(h->fl_bitmap)])];
+        break;
+    case ARM_MALLOC_SEGREGATED:
+        if (h->bucket_bitmap == 0) {
+            return 0;
+        }
+        list = h->free_buckets[arm_fls(h->bucket_bitmap)];
+        break;
+    default:
+        list = h->free_list;
+        break;
+    }
+
+    size_t largest = 0;
+    for (; list != NULL; list = list->next) {
+        if (block_size(list) > largest) {
+            largest = block_size(list);
+        }
+    }
+    return largest;
+}
+
+// 汇总各线程计数与共享堆计数器
+void heap_get_stats(heap_t *h, arm_malloc_stats_t *stats) {
+    thread_stats total;
+    memset(&total, 0, sizeof(total));
+    memset(stats, 0, sizeof(*stats));
+    if (h == NULL) {
+        return;
+    }
+
+    mutex_lock(&registry_mutex);
+#if defined(__linux__)
+    total = retired_stats[h->index];
+    for (thread_state *state = thread_states; state != NULL; state = state->next) {
+        if (state->heaps[h->index].generation == h->generation) {
+            stats_add(&total, &state->heaps[h->index].stats);
+        }
+    }
+#else
+    for (int i = 0; i < NUM_THREAD_STATES; i++) {
+        if (thread_states[i].heaps[h->index].generation == h->generation) {
+            stats_add(&total, &thread_states[i].heaps[h->index].stats);
+        }
+    }
+#endif
+    mutex_unlock(&registry_mutex);
+
+    heap_lock(h);
+    stats->heap_size = h->size;
+    stats->free_bytes = h->free_bytes;
+    stats->free_blocks = h->free_block_count;
+    stats->heap_used = h->size - h->free_bytes - h->free_block_count * META_SIZE;
+    stats->peak_heap_used = h->peak_heap_used;
+    stats->largest_free_block = largest_free_block(h);
+    heap_unlock(h);
+
+    stats->bytes_in_use = total.bytes_allocated - total.bytes_freed;
+    stats->alloc_count = total.alloc_count;
+    stats->free_count = total.free_count;
+    stats->failed_count = total.failed_count;
+    stats->realloc_in_place = total.realloc_in_place;
+    stats->realloc_moved = total.realloc_moved;
+    memcpy(stats->size_histogram, total.histogram, sizeof(stats->size_histogram));
+
+    // 外部碎片率 = 1 - 最大空闲块 / 空闲总量
+    if (stats->free_bytes > 0) {
+        stats->fragmentation_permille =
+            (unsigned)(1000 - (uint64_t)stats->largest_free_block * 1000 / stats->free_bytes);
+    }
+}
+
+void arm_malloc_get_stats(arm_malloc_stats_t *stats) {
+    heap_get_stats(default_heap, stats);
+}
+
+// 打印内存统计信息（my_printf 不支持长度修饰符，数值按 unsigned 输出）
+void arm_malloc_stats() {
+    arm_malloc_stats_t stats;
+    arm_malloc_get_stats(&stats);
+
+    my_printf("Heap stats:\n");
+    my_printf("  Total heap size: %u bytes\n", (unsigned)stats.heap_size);
+    my_printf("  Free memory: %u bytes in %u blocks, largest %u bytes\n",
+              (unsigned)stats.free_bytes, (unsigned)stats.free_blocks, (unsigned)stats.largest_free_block);
+    my_printf("  Heap used: %u bytes, peak %u bytes\n",
+              (unsigned)stats.heap_used, (unsigned)stats.peak_heap_used);
+    my_printf("  In use by callers: %u bytes\n", (unsigned)stats.bytes_in_use);
+    my_printf("  Fragmentation: %u.%u%%\n",
+              stats.fragmentation_permille / 10, stats.fragmentation_permille % 10);
+    my_printf("  malloc: %u ok, %u failed; free: %u\n",
+              (unsigned)stats.alloc_count, (unsigned)stats.failed_count, (unsigned)stats.free_count);
+    my_printf("  realloc: %u in place, %u moved\n",
+              (unsigned)stats.realloc_in_place, (unsigned)stats.realloc_moved);
+    my_printf("  Request size histogram:\n");
+    for (int i = 0; i < ARM_MALLOC_HIST_BINS; i++) {
+        if (stats.size_histogram[i] != 0) {
+            my_printf("    [%u, %u): %u\n", 1u << i, i + 1 < 32 ? 1u << (i + 1) : 0u,
+                      (unsigned)stats.size_histogram[i]);
+        }
+    }
+}
@@ -10,23 +10,176 @@
 
 // 内存块元数据结构
 typedef struct block_meta {
-    size_t size;            // 块大小（包括元数据）
-    struct block_meta *next; // 下一个空闲块
-    struct block_meta *prev; // 上一个空闲快
-    int free;               // 空闲标志
+    size_t prev_size;        // 边界标签：物理前一块的负载大小，仅当前一块空闲时有效
+    size_t size;             // 块的负载大小（不包括元数据），低 4 位为状态位
+    struct block_meta *next; // 下一个空闲块（紧凑块头时位于负载中）
+    struct block_meta *prev; // 上一个空闲快（紧凑块头时位于负载中）
     // 注意：在64位系统上，这个结构体大小为32字节（16字节对齐）
 } block_meta;
 
-#define META_SIZE ALIGN(sizeof(block_meta))
+// size 字段的状态位（块大小总是 ALIGNMENT 的倍数，低位可复用）
+#define BLOCK_FREE      ((size_t)1)  // 本块空闲
+#define BLOCK_PREV_FREE ((size_t)2)  // 物理前一块空闲，prev_size 有效
+#define BLOCK_MOVABLE   ((size_t)4)  // 句柄块，未锁定时可被整理搬移
+#define BLOCK_FLAGS     ((size_t)(ALIGNMENT - 1))
 
-// 内存分配函数
+// 紧凑块头：占用块只保留 size 一个字；prev_size 只在前一块空闲时有效，
+// 因此与前一块负载的末尾重叠，next/prev 只在空闲块（或缓存中的块）的负载里使用。
+// 64 位上每块开销从 32 字节降到 8 字节。定义为 0 恢复 32 字节的独立块头
+#ifndef ARM_MALLOC_COMPACT_HEADER
+#define ARM_MALLOC_COMPACT_HEADER 1
+#endif
+
+#if ARM_MALLOC_COMPACT_HEADER
+#define META_SIZE      ALIGN(2 * sizeof(size_t))      // 块地址到负载的距离
+#define HEADER_OVERLAP offsetof(block_meta, size)     // 占用块可借用的后继块 prev_size 字节
+#else
+#define META_SIZE      ALIGN(sizeof(block_meta))
+#define HEADER_OVERLAP 0
+#endif
+
+// 线程安全：共享堆加锁，小块经由按大小类划分的无锁快速箱，定义为 0 可关闭
+#ifndef ARM_MALLOC_THREAD_SAFE
+#define ARM_MALLOC_THREAD_SAFE 1
+#endif
+
+// 线程缓存：每个线程（裸机上为每个核）缓存最近释放的小块，定义为 0 可关闭
+#ifndef ARM_MALLOC_TCACHE
+#define ARM_MALLOC_TCACHE 1
+#endif
+
+// 微小对象层：不超过 64 字节的请求从按大小类划分的整页 run 中分配，对象不带块头，
+// 定义为 0 可关闭
+#ifndef ARM_MALLOC_TINY
+#define ARM_MALLOC_TINY 1
+#endif
+
+// 延迟合并：大于小块上限的块释放时先进入每个堆的有界队列，同样大小的请求直接复用；
+// 队列满、分配失败或调用 arm_malloc_maintenance 时才合并回堆。值为队列长度，定义为 0 可关闭
+#ifndef ARM_MALLOC_DEFER_QUEUE
+#define ARM_MALLOC_DEFER_QUEUE 16
+#endif
+
+// 句柄接口：hmalloc 返回句柄，hlock 取得临时指针；未锁定的块可被 heap_compact
+// 逐步搬移，把分散的空闲块并成大块。定义为 0 可关闭
+#ifndef ARM_MALLOC_HANDLES
+#define ARM_MALLOC_HANDLES 1
+#endif
+
+// 每个堆最多的句柄数（句柄表目录放在堆描述符中，每 128 个句柄占一个指针）
+#ifndef ARM_MALLOC_MAX_HANDLES
+#define ARM_MALLOC_MAX_HANDLES 32768
+#endif
+
+// 裸机 SMP 目标上的最大核数（每个核一份缓存）
+#ifndef ARM_MALLOC_MAX_CPUS
+#define ARM_MALLOC_MAX_CPUS 8
+#endif
+
+// 可同时存在的堆数（每个线程/核为每个堆保留一份缓存与计数）
+#ifndef ARM_MALLOC_MAX_HEAPS
+#define ARM_MALLOC_MAX_HEAPS 4
+#endif
+
+// 分配引擎，在 arm_malloc_init 时选择
+typedef enum {
+    ARM_MALLOC_FIRST_FIT = 0, // 首次适应（参考实现，耗时随碎片增长）
+    ARM_MALLOC_TLSF,          // 两级分离适配（TLSF），malloc/free 为 O(1)
+    ARM_MALLOC_SEGREGATED,    // 按 2 的幂分桶，桶内最佳适应
+} arm_malloc_mode;
+
+// 统计信息：计数器在分配/释放路径上以 O(1) 维护，可在发布版本中常开
+#define ARM_MALLOC_HIST_BINS 32
+
+typedef struct {
+    size_t heap_size;
+    size_t bytes_in_use;          // 调用者持有的块负载字节数
+    size_t heap_used;             // 共享堆已占用字节（含元数据和缓存中的块）
+    size_t peak_heap_used;        // heap_used 的历史峰值
+    size_t free_bytes;            // 空闲块负载总和
+    size_t free_blocks;           // 空闲块数量
+    size_t largest_free_block;    // 最大空闲块负载
+    unsigned fragmentation_permille;  // 外部碎片率（千分比）：1 - 最大空闲块 / 空闲总量
+    unsigned long alloc_count;
+    unsigned long free_count;
+    unsigned long failed_count;
+    unsigned long realloc_in_place;
+    unsigned long realloc_moved;
+    unsigned long size_histogram[ARM_MALLOC_HIST_BINS];  // 第 i 桶为请求大小 [2^i, 2^(i+1))
+} arm_malloc_stats_t;
+
+// 堆对象：每段内存区域（如片上 SRAM、片外 DDR）一个。
+// 一个堆分配失败时沿回退链尝试下一个堆；释放和 realloc 按地址找到所属的堆
+typedef struct heap heap_t;
+
+// 堆描述符（索引表、快速箱、延迟队列、句柄目录等）大小的上界，随上面的配置变化，
+// 默认配置在 64 位上约 7 KiB。heap_create 把描述符放在区域开头，区域不小于
+// ARM_HEAP_MIN_REGION 时（且堆数未满）一定创建成功；小块快速内存（如 DTCM）
+// 应改用 heap_create_at，把描述符放在其他内存中，区域全部用作块区
+#define ARM_HEAP_DESC_SIZE                                                        \
+    (448 * sizeof(void *) + 320                                                   \
+     + ARM_MALLOC_THREAD_SAFE * (512 / ALIGNMENT) * 16                            \
+     + ARM_MALLOC_TINY * (16 + 4 * (sizeof(void *) + 64))                         \
+     + ARM_MALLOC_DEFER_QUEUE * 2 * sizeof(void *) + 8                            \
+     + ARM_MALLOC_HANDLES * ((ARM_MALLOC_MAX_HANDLES + 127) / 128 * sizeof(void *) + 16))
+#define ARM_HEAP_MIN_REGION (ARM_HEAP_DESC_SIZE + 256)
+
+heap_t *heap_create(void *start, size_t size, arm_malloc_mode mode);  // 区域过小或堆数已满时返回 NULL；超过 4 GiB 的区域只使用前 4 GiB
+// 描述符放在 desc 指向的存储中（至少 ARM_HEAP_DESC_SIZE 字节，与堆同寿命），其余同 heap_create
+heap_t *heap_create_at(void *desc, size_t desc_size, void *start, size_t size, arm_malloc_mode mode);
+void heap_destroy(heap_t *heap);                  // 注销堆，其中的块全部作废
+int heap_set_fallback(heap_t *heap, heap_t *fallback);  // 成功返回 0，形成环时返回 -1
+void *heap_malloc(heap_t *heap, size_t size);
+void *heap_memalign(heap_t *heap, size_t alignment, size_t size);
+void heap_free(void *ptr);                        // 不属于任何堆的指针被忽略
+void *heap_realloc(void *ptr, size_t size);       // 在所属的堆上调整，必要时沿其回退链搬移
+void *heap_calloc(heap_t *heap, size_t num, size_t size);  // num * size 溢出时返回 NULL
+void heap_assume_zeroed(heap_t *heap);            // 声明区域未写过的部分为零（如位于 .bss），calloc 不再重复清零
+void heap_get_stats(heap_t *heap, arm_malloc_stats_t *stats);
+size_t heap_malloc_batch(heap_t *heap, size_t size, size_t n, void **out);
+void heap_free_batch(void **ptrs, size_t n);
+void heap_maintenance(heap_t *heap);              // 把延迟队列与各级缓存中的块合并回堆
+
+// 内存分配函数：作用于默认堆（arm_malloc_init 创建）
 void *arm_malloc(size_t size);
 void arm_free(void *ptr);
-void *arm_calloc(size_t num, size_t size);
+void *arm_calloc(size_t num, size_t size);               // 只清除不能确定为零的部分
 void *arm_realloc(void *ptr, size_t size);
+void *arm_memalign(size_t alignment, size_t size);       // alignment 须为 2 的幂
+void *arm_aligned_alloc(size_t alignment, size_t size);
+
+// 批量接口：n 个同样大小的块从一段连续区域切出，返回成功分配的个数；
+// 批量释放按地址排序后一次合并相邻块（会重新排列 ptrs 数组）
+size_t arm_malloc_batch(size_t size, size_t n, void **out);
+void arm_free_batch(void **ptrs, size_t n);
+
+#if ARM_MALLOC_HANDLES
+// 句柄：高 8 位为堆编号，低 24 位为句柄表槽号，0 表示无效
+typedef uint32_t arm_handle_t;
+
+arm_handle_t heap_hmalloc(heap_t *heap, size_t size);  // 失败返回 0，沿回退链尝试
+arm_handle_t hmalloc(size_t size);                     // 在默认堆上分配
+void hfree(arm_handle_t handle);
+void *hlock(arm_handle_t handle);       // 锁定期间块不会移动，可嵌套
+void hunlock(arm_handle_t handle);      // 指针在最后一次解锁后失效
+
+// 增量整理：把未锁定的句柄块滑向低地址，与其前方的空闲块交换位置。
+// 每次调用搬移的字节数（每访问一个块另计 META_SIZE）不超过 budget，
+// 可在空闲任务中周期调用；大于 budget 的块不会被搬移。返回实际搬移的字节数
+size_t heap_compact(heap_t *heap, size_t budget);
+size_t arm_malloc_compact(size_t budget);
+#endif
 
 // 堆管理函数
-void arm_malloc_init(void *heap_start, size_t heap_size);
-void arm_malloc_stats();
+// 成功返回 0；区域小于 ARM_HEAP_MIN_REGION 等原因创建失败时返回 -1，此时没有默认堆，所有分配返回 NULL
+int arm_malloc_init(void *heap_start, size_t heap_size);  // 默认使用 TLSF 引擎
+int arm_malloc_init_mode(void *heap_start, size_t heap_size, arm_malloc_mode mode);
+heap_t *arm_malloc_default_heap(void);
+void arm_malloc_set_default_heap(heap_t *heap);   // 例如把快堆设为默认、慢堆作为其回退
+void arm_malloc_tcache_enable(int enable);  // 运行时开关线程缓存（默认开启）
+void arm_malloc_tcache_flush(void);         // 把当前线程缓存的块全部还给共享堆
+void arm_malloc_maintenance(void);          // 空闲循环中调用，集中完成延迟的合并
+void arm_malloc_get_stats(arm_malloc_stats_t *stats);
+void arm_malloc_stats();                    // 用 my_printf 打印统计信息
 
-#endif // ARM_MALLOC_H
\ No newline at end of file
+#endif // ARM_MALLOC_H
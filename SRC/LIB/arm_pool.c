@@ -0,0 +1,113 @@
+#include "arm_pool.h"
+#include "arm_malloc.h"
+
+// slab 头部，位于每块从 arm_malloc 取得的内存起始处
+typedef struct pool_slab {
+    struct pool_slab *next;
+} pool_slab;
+
+// 空闲对象：复用对象自身的首字保存链表指针
+typedef struct pool_free_obj {
+    struct pool_free_obj *next;
+} pool_free_obj;
+
+struct arm_pool {
+    size_t stride;          // 对象间距（对齐到缓存行）
+    size_t per_slab;        // 每个 slab 的对象数
+    pool_free_obj *free;    // 空闲对象链表
+    pool_slab *slabs;       // 已分配的 slab 链表
+};
+
+#define POOL_ALIGN(x) (((x) + (ARM_POOL_CACHE_LINE - 1)) & ~(size_t)(ARM_POOL_CACHE_LINE - 1))
+
+// 新切一个 slab，并把其中所有对象挂到空闲链表
+static int pool_grow(arm_pool *pool) {
+    // slab 本身按缓存行对齐，头部占用第一个缓存行
+    size_t bytes = POOL_ALIGN(sizeof(pool_slab)) + pool->stride * pool->per_slab;
+    pool_slab *slab = (pool_slab *)arm_memalign(ARM_POOL_CACHE_LINE, bytes);
+    if (slab == NULL) {
+        return 0;
+    }
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+
+    char *obj = (char *)slab + POOL_ALIGN(sizeof(pool_slab));
+    // 倒序入链，使分配顺序与地址顺序一致
+    for (size_t i = pool->per_slab; i > 0; i--) {
+        pool_free_obj *node = (pool_free_obj *)(obj + (i - 1) * pool->stride);
+        node->next = pool->free;
+        pool->free = node;
+    }
+    return 1;
+}
+
+arm_pool *arm_pool_create(size_t obj_size, size_t count) {
+    if (obj_size == 0 || count == 0) {
+        return NULL;
+    }
+    if (obj_size < sizeof(pool_free_obj)) {
+        obj_size = sizeof(pool_free_obj);
+    }
+
+    // 对象间距与 slab 大小都不能溢出，否则 slab 分配偏小，串链表时写出界
+    if (obj_size > (size_t)-1 - (ARM_POOL_CACHE_LINE - 1)) {
+        return NULL;
+    }
+    size_t stride = POOL_ALIGN(obj_size);
+    if (count > ((size_t)-1 - POOL_ALIGN(sizeof(pool_slab))) / stride) {
+        return NULL;
+    }
+
+    arm_pool *pool = (arm_pool *)arm_malloc(sizeof(arm_pool));
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    pool->stride = stride;
+    pool->per_slab = count;
+    pool->free = NULL;
+    pool->slabs = NULL;
+
+    if (!pool_grow(pool)) {
+        arm_free(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void *arm_pool_alloc(arm_pool *pool) {
+    if (pool == NULL) {
+        return NULL;
+    }
+    if (pool->free == NULL && !pool_grow(pool)) {
+        return NULL;
+    }
+
+    pool_free_obj *obj = pool->free;
+    pool->free = obj->next;
+    return obj;
+}
+
+void arm_pool_free(arm_pool *pool, void *obj) {
+    if (pool == NULL || obj == NULL) {
+        return;
+    }
+
+    pool_free_obj *node = (pool_free_obj *)obj;
+    node->next = pool->free;
+    pool->free = node;
+}
+
+void arm_pool_destroy(arm_pool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    pool_slab *slab = pool->slabs;
+    while (slab != NULL) {
+        pool_slab *next = slab->next;
+        arm_free(slab);
+        slab = next;
+    }
+    arm_free(pool);
+}
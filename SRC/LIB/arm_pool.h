@@ -0,0 +1,19 @@
+#ifndef ARM_POOL_H
+#define ARM_POOL_H
+
+#include <stddef.h>
+
+// 对象按缓存行对齐（Cortex-A 系列为 64 字节）
+#define ARM_POOL_CACHE_LINE 64
+
+// 固定大小对象池：从 arm_malloc 堆中成批切出 slab，对象本身没有元数据，
+// 空闲对象通过首字构成侵入式链表，分配与释放都是 O(1)。
+// 对象池不加锁，多线程共享时由调用者负责同步。
+typedef struct arm_pool arm_pool;
+
+arm_pool *arm_pool_create(size_t obj_size, size_t count);  // count 为每个 slab 的对象数，slab 大小溢出时返回 NULL
+void *arm_pool_alloc(arm_pool *pool);
+void arm_pool_free(arm_pool *pool, void *obj);
+void arm_pool_destroy(arm_pool *pool);                     // 释放全部 slab
+
+#endif // ARM_POOL_H
@@ -1,5 +1,14 @@
 #include <stddef.h> // for size_t
 #include <stdint.h>
+#include "my_memory.h"
+
+#if defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#include <unistd.h>
+#endif
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif
 
 void* my_memcpy_basic(void* dest, const void* src, size_t n) {
     // 将参数转换为字节指针
@@ -18,39 +27,61 @@ void* my_memcpy(void* dest, const void* src, size_t n) {
     // 将参数转换为字节指针
     char* d = (char*) dest;
     const char* s = (const char*) src;
+    const size_t W = sizeof(size_t);
     
-    // 检查地址对齐情况
-    size_t align = (sizeof(void*) - 1);
-    size_t misalign_mask = (size_t)s | (size_t)d;
-    
-    // 如果源地址或目标地址没有对齐，或者复制的数据量很小，使用逐字节复制
-    if ((misalign_mask & align) || n < sizeof(void*)) {
+    // 复制的数据量很小时，使用逐字节复制
+    if (n < 4 * W) {
         for (size_t i = 0; i < n; i++) {
             d[i] = s[i];
         }
         return dest;
     }
     
-    // 复制前面对齐部分（逐字节）
-    size_t prefix = ((sizeof(void*) - ((size_t)d & align)) & align);
+    // 复制前面部分（逐字节），直到目标地址对齐
+    size_t prefix = (W - ((size_t)d & (W - 1))) & (W - 1);
+    size_t shift = ((size_t)s + prefix) & (W - 1);
+    if (shift != 0) {
+        // 源未对齐时多复制一个字，保证下面第一次对齐加载不早于源的开头
+        prefix += W;
+    }
     for (size_t i = 0; i < prefix; i++) {
         d[i] = s[i];
     }
+    d += prefix;
+    s += prefix;
+    n -= prefix;
     
-    // 使用字长复制主体部分
-    size_t words = (n - prefix) / sizeof(void*);
-    size_t* d_word = (size_t*)(d + prefix);
-    const size_t* s_word = (const size_t*)(s + prefix);
-    
-    for (size_t i = 0; i < words; i++) {
-        d_word[i] = s_word[i];
+    size_t* d_word = (size_t*)d;
+    size_t words;
+    if (shift == 0) {
+        // 两者都已对齐，直接按字长复制主体部分
+        const size_t* s_word = (const size_t*)s;
+        words = n / W;
+        for (size_t i = 0; i < words; i++) {
+            d_word[i] = s_word[i];
+        }
+    } else {
+        // 源未对齐：只做对齐的加载，相邻两个字移位拼出一个目标字。
+        // 第 i 个目标字用到第 i、i+1 个源字，words 保证最后一次加载不越过源的末尾
+        const size_t* s_word = (const size_t*)(s - shift);
+        unsigned lo = (unsigned)(8 * shift);
+        unsigned hi = (unsigned)(8 * (W - shift));
+        words = (n + shift) / W - 1;
+        size_t prev = s_word[0];
+        for (size_t i = 0; i < words; i++) {
+            size_t next = s_word[i + 1];
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            d_word[i] = (prev << lo) | (next >> hi);
+#else
+            d_word[i] = (prev >> lo) | (next << hi);
+#endif
+            prev = next;
+        }
     }
     
     // 复制剩余尾部（逐字节）
-    size_t suffix = (n - prefix) % sizeof(void*);
-    size_t tail_start = prefix + words * sizeof(void*);
-    for (size_t i = 0; i < suffix; i++) {
-        d[tail_start + i] = s[tail_start + i];
+    for (size_t i = words * W; i < n; i++) {
+        d[i] = s[i];
     }
     
     return dest;
@@ -63,11 +94,8 @@ void* my_memcpy_fast(void* dest, const void* src, size_t n) {
     
     // 检查重叠情况（memcpy不处理重叠，但这里作为安全措施）
     if (d > s && d < s + n) {
-        // 如果目标地址在源地址范围内，从后向前复制
-        for (size_t i = n; i > 0; i--) {
-            d[i-1] = s[i-1];
-        }
-        return dest;
+        // 如果目标地址在源地址范围内，交给按字长反向复制的 memmove
+        return my_memmove(dest, src, n);
     }
     
     // 使用寄存器变量加速复制
@@ -97,6 +125,137 @@ void* my_memcpy_fast(void* dest, const void* src, size_t n) {
     return dest;
 }
 
+// 字长复制：逐字节对齐目标地址后按 8 字节一组复制，源地址未对齐时由
+// __builtin_memcpy 生成非对齐加载，不会像上面两个版本那样退回逐字节
+void* my_memcpy_word(void* dest, const void* src, size_t n) {
+    unsigned char* d = (unsigned char*)dest;
+    const unsigned char* s = (const unsigned char*)src;
+
+    if (n >= 2 * sizeof(uint64_t)) {
+        size_t align = (0 - (uintptr_t)d) & (sizeof(uint64_t) - 1);
+        for (size_t i = 0; i < align; i++) {
+            d[i] = s[i];
+        }
+        d += align;
+        s += align;
+        n -= align;
+
+        // 每轮 32 字节，四个加载先于存储发出
+        while (n >= 32) {
+            uint64_t a, b, c, e;
+            __builtin_memcpy(&a, s, 8);
+            __builtin_memcpy(&b, s + 8, 8);
+            __builtin_memcpy(&c, s + 16, 8);
+            __builtin_memcpy(&e, s + 24, 8);
+            __builtin_memcpy(d, &a, 8);
+            __builtin_memcpy(d + 8, &b, 8);
+            __builtin_memcpy(d + 16, &c, 8);
+            __builtin_memcpy(d + 24, &e, 8);
+            d += 32;
+            s += 32;
+            n -= 32;
+        }
+        while (n >= 8) {
+            uint64_t a;
+            __builtin_memcpy(&a, s, 8);
+            __builtin_memcpy(d, &a, 8);
+            d += 8;
+            s += 8;
+            n -= 8;
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        d[i] = s[i];
+    }
+    return dest;
+}
+
+// 重叠安全的复制。目标在源之后且两者重叠时从高地址向低地址复制，否则正向复制，
+// 两个方向都按字长进行：首尾在主循环之前读出、最后写入，主循环读取的源数据
+// 总在已写入的目标范围之外
+void* my_memmove(void* dest, const void* src, size_t n) {
+    unsigned char* d = (unsigned char*)dest;
+    const unsigned char* s = (const unsigned char*)src;
+
+    if (d == s) {
+        return dest;
+    }
+    if (n <= 32) {
+        // 先读出全部数据再写入，重叠时同样正确
+        return pbs_memcpy_small(dest, src, n);
+    }
+
+    if ((uintptr_t)d - (uintptr_t)s >= n) {
+        // 目标在源之前或不重叠：正向
+        uint64_t head, t0, t1, t2, t3;
+        __builtin_memcpy(&head, s, 8);
+        __builtin_memcpy(&t0, s + n - 32, 8);
+        __builtin_memcpy(&t1, s + n - 24, 8);
+        __builtin_memcpy(&t2, s + n - 16, 8);
+        __builtin_memcpy(&t3, s + n - 8, 8);
+
+        size_t skew = 8 - ((uintptr_t)d & 7);
+        unsigned char* dst = d + skew;
+        const unsigned char* src_p = s + skew;
+        size_t left = n - skew;
+        while (left > 32) {
+            uint64_t a, b, c, e;
+            __builtin_memcpy(&a, src_p, 8);
+            __builtin_memcpy(&b, src_p + 8, 8);
+            __builtin_memcpy(&c, src_p + 16, 8);
+            __builtin_memcpy(&e, src_p + 24, 8);
+            __builtin_memcpy(dst, &a, 8);
+            __builtin_memcpy(dst + 8, &b, 8);
+            __builtin_memcpy(dst + 16, &c, 8);
+            __builtin_memcpy(dst + 24, &e, 8);
+            dst += 32;
+            src_p += 32;
+            left -= 32;
+        }
+
+        __builtin_memcpy(d + n - 32, &t0, 8);
+        __builtin_memcpy(d + n - 24, &t1, 8);
+        __builtin_memcpy(d + n - 16, &t2, 8);
+        __builtin_memcpy(d + n - 8, &t3, 8);
+        __builtin_memcpy(d, &head, 8);
+    } else {
+        // 目标在源之后且重叠：反向
+        uint64_t h0, h1, h2, h3, tail;
+        __builtin_memcpy(&h0, s, 8);
+        __builtin_memcpy(&h1, s + 8, 8);
+        __builtin_memcpy(&h2, s + 16, 8);
+        __builtin_memcpy(&h3, s + 24, 8);
+        __builtin_memcpy(&tail, s + n - 8, 8);
+
+        size_t skew = (uintptr_t)(d + n) & 7;
+        unsigned char* dst_end = d + n - skew;
+        const unsigned char* src_end = s + n - skew;
+        size_t left = n - skew;
+        while (left > 32) {
+            uint64_t a, b, c, e;
+            dst_end -= 32;
+            src_end -= 32;
+            __builtin_memcpy(&a, src_end, 8);
+            __builtin_memcpy(&b, src_end + 8, 8);
+            __builtin_memcpy(&c, src_end + 16, 8);
+            __builtin_memcpy(&e, src_end + 24, 8);
+            __builtin_memcpy(dst_end, &a, 8);
+            __builtin_memcpy(dst_end + 8, &b, 8);
+            __builtin_memcpy(dst_end + 16, &c, 8);
+            __builtin_memcpy(dst_end + 24, &e, 8);
+            left -= 32;
+        }
+
+        __builtin_memcpy(d, &h0, 8);
+        __builtin_memcpy(d + 8, &h1, 8);
+        __builtin_memcpy(d + 16, &h2, 8);
+        __builtin_memcpy(d + 24, &h3, 8);
+        __builtin_memcpy(d + n - 8, &tail, 8);
+    }
+    return dest;
+}
+
 #if defined(__aarch64__) && defined(__ARM_NEON)
 #include <arm_neon.h>
 
@@ -138,6 +297,95 @@ void* my_memcpy_neon(void* dest, const void* src, size_t n) {
     
     return dest;
 }
+
+// NEON 版本的 memmove：结构同 my_memmove，每轮 64 字节，主体按 16 字节对齐存储
+void* my_memmove_neon(void* dest, const void* src, size_t n) {
+    uint8_t* d = (uint8_t*)dest;
+    const uint8_t* s = (const uint8_t*)src;
+
+    if (d == s) {
+        return dest;
+    }
+    if (n <= 32) {
+        return pbs_memcpy_small(dest, src, n);
+    }
+    if (n <= 64) {
+        uint8x16_t a = vld1q_u8(s);
+        uint8x16_t b = vld1q_u8(s + 16);
+        uint8x16_t c = vld1q_u8(s + n - 32);
+        uint8x16_t e = vld1q_u8(s + n - 16);
+        vst1q_u8(d, a);
+        vst1q_u8(d + 16, b);
+        vst1q_u8(d + n - 32, c);
+        vst1q_u8(d + n - 16, e);
+        return dest;
+    }
+
+    if ((uintptr_t)d - (uintptr_t)s >= n) {
+        // 正向：头部 16 字节和尾部 64 字节先读出
+        uint8x16_t head = vld1q_u8(s);
+        uint8x16_t t0 = vld1q_u8(s + n - 64);
+        uint8x16_t t1 = vld1q_u8(s + n - 48);
+        uint8x16_t t2 = vld1q_u8(s + n - 32);
+        uint8x16_t t3 = vld1q_u8(s + n - 16);
+
+        size_t skew = 16 - ((uintptr_t)d & 15);
+        uint8_t* dst = d + skew;
+        const uint8_t* src_p = s + skew;
+        size_t left = n - skew;
+        while (left > 64) {
+            uint8x16_t a = vld1q_u8(src_p);
+            uint8x16_t b = vld1q_u8(src_p + 16);
+            uint8x16_t c = vld1q_u8(src_p + 32);
+            uint8x16_t e = vld1q_u8(src_p + 48);
+            vst1q_u8(dst, a);
+            vst1q_u8(dst + 16, b);
+            vst1q_u8(dst + 32, c);
+            vst1q_u8(dst + 48, e);
+            dst += 64;
+            src_p += 64;
+            left -= 64;
+        }
+
+        vst1q_u8(d + n - 64, t0);
+        vst1q_u8(d + n - 48, t1);
+        vst1q_u8(d + n - 32, t2);
+        vst1q_u8(d + n - 16, t3);
+        vst1q_u8(d, head);
+    } else {
+        // 反向：头部 64 字节和尾部 16 字节先读出
+        uint8x16_t h0 = vld1q_u8(s);
+        uint8x16_t h1 = vld1q_u8(s + 16);
+        uint8x16_t h2 = vld1q_u8(s + 32);
+        uint8x16_t h3 = vld1q_u8(s + 48);
+        uint8x16_t tail = vld1q_u8(s + n - 16);
+
+        size_t skew = (uintptr_t)(d + n) & 15;
+        uint8_t* dst_end = d + n - skew;
+        const uint8_t* src_end = s + n - skew;
+        size_t left = n - skew;
+        while (left > 64) {
+            dst_end -= 64;
+            src_end -= 64;
+            uint8x16_t a = vld1q_u8(src_end);
+            uint8x16_t b = vld1q_u8(src_end + 16);
+            uint8x16_t c = vld1q_u8(src_end + 32);
+            uint8x16_t e = vld1q_u8(src_end + 48);
+            vst1q_u8(dst_end, a);
+            vst1q_u8(dst_end + 16, b);
+            vst1q_u8(dst_end + 32, c);
+            vst1q_u8(dst_end + 48, e);
+            left -= 64;
+        }
+
+        vst1q_u8(d, h0);
+        vst1q_u8(d + 16, h1);
+        vst1q_u8(d + 32, h2);
+        vst1q_u8(d + 48, h3);
+        vst1q_u8(d + n - 16, tail);
+    }
+    return dest;
+}
 #endif
 
 // 基本实现 - 逐字节填充
@@ -241,4 +489,617 @@ void* my_memset_neon(void* dest, int value, size_t count) {
     
     return dest;
 }
-#endif
\ No newline at end of file
+#endif
+
+// x86-64 主机构建：SSE2 为基线，AVX2 在运行时检测后才会被选用。
+// 首尾各用一次非对齐向量访问覆盖，主体按目标地址对齐后存储，
+// 首尾与主体的重叠部分被写两次，省去逐字节处理
+#if defined(__x86_64__)
+#include <immintrin.h>
+
+void* my_memcpy_sse2(void* dest, const void* src, size_t n) {
+    unsigned char* d = (unsigned char*)dest;
+    const unsigned char* s = (const unsigned char*)src;
+
+    if (n <= 16) {
+        return pbs_memcpy_small(dest, src, n);
+    }
+    if (n <= 32) {
+        __m128i a = _mm_loadu_si128((const __m128i*)s);
+        __m128i b = _mm_loadu_si128((const __m128i*)(s + n - 16));
+        _mm_storeu_si128((__m128i*)d, a);
+        _mm_storeu_si128((__m128i*)(d + n - 16), b);
+        return dest;
+    }
+    if (n <= 64) {
+        __m128i a = _mm_loadu_si128((const __m128i*)s);
+        __m128i b = _mm_loadu_si128((const __m128i*)(s + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(s + n - 32));
+        __m128i e = _mm_loadu_si128((const __m128i*)(s + n - 16));
+        _mm_storeu_si128((__m128i*)d, a);
+        _mm_storeu_si128((__m128i*)(d + 16), b);
+        _mm_storeu_si128((__m128i*)(d + n - 32), c);
+        _mm_storeu_si128((__m128i*)(d + n - 16), e);
+        return dest;
+    }
+
+    // 头部 16 字节先取出，最后写入；主体从下一个 16 字节边界开始
+    __m128i head = _mm_loadu_si128((const __m128i*)s);
+    size_t skew = 16 - ((uintptr_t)d & 15);
+    unsigned char* dst = d + skew;
+    const unsigned char* src_p = s + skew;
+    size_t left = n - skew;
+
+    while (left > 64) {
+        __m128i a = _mm_loadu_si128((const __m128i*)src_p);
+        __m128i b = _mm_loadu_si128((const __m128i*)(src_p + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(src_p + 32));
+        __m128i e = _mm_loadu_si128((const __m128i*)(src_p + 48));
+        _mm_store_si128((__m128i*)dst, a);
+        _mm_store_si128((__m128i*)(dst + 16), b);
+        _mm_store_si128((__m128i*)(dst + 32), c);
+        _mm_store_si128((__m128i*)(dst + 48), e);
+        dst += 64;
+        src_p += 64;
+        left -= 64;
+    }
+
+    // 剩余不超过 64 字节：以末尾为准写最后 64 字节
+    __m128i a = _mm_loadu_si128((const __m128i*)(s + n - 64));
+    __m128i b = _mm_loadu_si128((const __m128i*)(s + n - 48));
+    __m128i c = _mm_loadu_si128((const __m128i*)(s + n - 32));
+    __m128i e = _mm_loadu_si128((const __m128i*)(s + n - 16));
+    _mm_storeu_si128((__m128i*)(d + n - 64), a);
+    _mm_storeu_si128((__m128i*)(d + n - 48), b);
+    _mm_storeu_si128((__m128i*)(d + n - 32), c);
+    _mm_storeu_si128((__m128i*)(d + n - 16), e);
+    _mm_storeu_si128((__m128i*)d, head);
+    return dest;
+}
+
+void* my_memset_sse2(void* dest, int value, size_t count) {
+    unsigned char* d = (unsigned char*)dest;
+
+    if (count <= 16) {
+        return pbs_memset_small(dest, value, count);
+    }
+    __m128i v = _mm_set1_epi8((char)value);
+    if (count <= 32) {
+        _mm_storeu_si128((__m128i*)d, v);
+        _mm_storeu_si128((__m128i*)(d + count - 16), v);
+        return dest;
+    }
+    if (count <= 64) {
+        _mm_storeu_si128((__m128i*)d, v);
+        _mm_storeu_si128((__m128i*)(d + 16), v);
+        _mm_storeu_si128((__m128i*)(d + count - 32), v);
+        _mm_storeu_si128((__m128i*)(d + count - 16), v);
+        return dest;
+    }
+
+    _mm_storeu_si128((__m128i*)d, v);
+    unsigned char* dst = (unsigned char*)(((uintptr_t)d + 16) & ~(uintptr_t)15);
+    unsigned char* end = d + count;
+    while ((size_t)(end - dst) > 64) {
+        _mm_store_si128((__m128i*)dst, v);
+        _mm_store_si128((__m128i*)(dst + 16), v);
+        _mm_store_si128((__m128i*)(dst + 32), v);
+        _mm_store_si128((__m128i*)(dst + 48), v);
+        dst += 64;
+    }
+    _mm_storeu_si128((__m128i*)(end - 64), v);
+    _mm_storeu_si128((__m128i*)(end - 48), v);
+    _mm_storeu_si128((__m128i*)(end - 32), v);
+    _mm_storeu_si128((__m128i*)(end - 16), v);
+    return dest;
+}
+
+// SSE2 版本的 memmove：结构同 my_memmove_neon
+void* my_memmove_sse2(void* dest, const void* src, size_t n) {
+    unsigned char* d = (unsigned char*)dest;
+    const unsigned char* s = (const unsigned char*)src;
+
+    if (d == s) {
+        return dest;
+    }
+    if (n <= 32) {
+        return pbs_memcpy_small(dest, src, n);
+    }
+    if (n <= 64) {
+        __m128i a = _mm_loadu_si128((const __m128i*)s);
+        __m128i b = _mm_loadu_si128((const __m128i*)(s + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(s + n - 32));
+        __m128i e = _mm_loadu_si128((const __m128i*)(s + n - 16));
+        _mm_storeu_si128((__m128i*)d, a);
+        _mm_storeu_si128((__m128i*)(d + 16), b);
+        _mm_storeu_si128((__m128i*)(d + n - 32), c);
+        _mm_storeu_si128((__m128i*)(d + n - 16), e);
+        return dest;
+    }
+
+    if ((uintptr_t)d - (uintptr_t)s >= n) {
+        __m128i head = _mm_loadu_si128((const __m128i*)s);
+        __m128i t0 = _mm_loadu_si128((const __m128i*)(s + n - 64));
+        __m128i t1 = _mm_loadu_si128((const __m128i*)(s + n - 48));
+        __m128i t2 = _mm_loadu_si128((const __m128i*)(s + n - 32));
+        __m128i t3 = _mm_loadu_si128((const __m128i*)(s + n - 16));
+
+        size_t skew = 16 - ((uintptr_t)d & 15);
+        unsigned char* dst = d + skew;
+        const unsigned char* src_p = s + skew;
+        size_t left = n - skew;
+        while (left > 64) {
+            __m128i a = _mm_loadu_si128((const __m128i*)src_p);
+            __m128i b = _mm_loadu_si128((const __m128i*)(src_p + 16));
+            __m128i c = _mm_loadu_si128((const __m128i*)(src_p + 32));
+            __m128i e = _mm_loadu_si128((const __m128i*)(src_p + 48));
+            _mm_store_si128((__m128i*)dst, a);
+            _mm_store_si128((__m128i*)(dst + 16), b);
+            _mm_store_si128((__m128i*)(dst + 32), c);
+            _mm_store_si128((__m128i*)(dst + 48), e);
+            dst += 64;
+            src_p += 64;
+            left -= 64;
+        }
+
+        _mm_storeu_si128((__m128i*)(d + n - 64), t0);
+        _mm_storeu_si128((__m128i*)(d + n - 48), t1);
+        _mm_storeu_si128((__m128i*)(d + n - 32), t2);
+        _mm_storeu_si128((__m128i*)(d + n - 16), t3);
+        _mm_storeu_si128((__m128i*)d, head);
+    } else {
+        __m128i h0 = _mm_loadu_si128((const __m128i*)s);
+        __m128i h1 = _mm_loadu_si128((const __m128i*)(s + 16));
+        __m128i h2 = _mm_loadu_si128((const __m128i*)(s + 32));
+        __m128i h3 = _mm_loadu_si128((const __m128i*)(s + 48));
+        __m128i tail = _mm_loadu_si128((const __m128i*)(s + n - 16));
+
+        size_t skew = (uintptr_t)(d + n) & 15;
+        unsigned char* dst_end = d + n - skew;
+        const unsigned char* src_end = s + n - skew;
+        size_t left = n - skew;
+        while (left > 64) {
+            dst_end -= 64;
+            src_end -= 64;
+            __m128i a = _mm_loadu_si128((const __m128i*)src_end);
+            __m128i b = _mm_loadu_si128((const __m128i*)(src_end + 16));
+            __m128i c = _mm_loadu_si128((const __m128i*)(src_end + 32));
+            __m128i e = _mm_loadu_si128((const __m128i*)(src_end + 48));
+            _mm_store_si128((__m128i*)dst_end, a);
+            _mm_store_si128((__m128i*)(dst_end + 16), b);
+            _mm_store_si128((__m128i*)(dst_end + 32), c);
+            _mm_store_si128((__m128i*)(dst_end + 48), e);
+            left -= 64;
+        }
+
+        _mm_storeu_si128((__m128i*)d, h0);
+        _mm_storeu_si128((__m128i*)(d + 16), h1);
+        _mm_storeu_si128((__m128i*)(d + 32), h2);
+        _mm_storeu_si128((__m128i*)(d + 48), h3);
+        _mm_storeu_si128((__m128i*)(d + n - 16), tail);
+    }
+    return dest;
+}
+
+// 大块流式版本：主体用 movntdq 绕过缓存直接写内存，不挤占工作集，也没有写分配
+// 的读取开销；结束前 sfence 使非临时存储对其他核可见后再返回
+void* my_memcpy_stream_sse2(void* dest, const void* src, size_t n) {
+    unsigned char* d = (unsigned char*)dest;
+    const unsigned char* s = (const unsigned char*)src;
+
+    if (n < 128) {
+        return my_memcpy_sse2(dest, src, n);
+    }
+
+    __m128i head = _mm_loadu_si128((const __m128i*)s);
+    __m128i t0 = _mm_loadu_si128((const __m128i*)(s + n - 64));
+    __m128i t1 = _mm_loadu_si128((const __m128i*)(s + n - 48));
+    __m128i t2 = _mm_loadu_si128((const __m128i*)(s + n - 32));
+    __m128i t3 = _mm_loadu_si128((const __m128i*)(s + n - 16));
+
+    size_t skew = 16 - ((uintptr_t)d & 15);
+    unsigned char* dst = d + skew;
+    const unsigned char* src_p = s + skew;
+    size_t left = n - skew;
+    while (left > 64) {
+        __m128i a = _mm_loadu_si128((const __m128i*)src_p);
+        __m128i b = _mm_loadu_si128((const __m128i*)(src_p + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(src_p + 32));
+        __m128i e = _mm_loadu_si128((const __m128i*)(src_p + 48));
+        _mm_stream_si128((__m128i*)dst, a);
+        _mm_stream_si128((__m128i*)(dst + 16), b);
+        _mm_stream_si128((__m128i*)(dst + 32), c);
+        _mm_stream_si128((__m128i*)(dst + 48), e);
+        dst += 64;
+        src_p += 64;
+        left -= 64;
+    }
+    _mm_sfence();
+
+    _mm_storeu_si128((__m128i*)(d + n - 64), t0);
+    _mm_storeu_si128((__m128i*)(d + n - 48), t1);
+    _mm_storeu_si128((__m128i*)(d + n - 32), t2);
+    _mm_storeu_si128((__m128i*)(d + n - 16), t3);
+    _mm_storeu_si128((__m128i*)d, head);
+    return dest;
+}
+
+void* my_memset_stream_sse2(void* dest, int value, size_t count) {
+    unsigned char* d = (unsigned char*)dest;
+
+    if (count < 128) {
+        return my_memset_sse2(dest, value, count);
+    }
+
+    __m128i v = _mm_set1_epi8((char)value);
+    _mm_storeu_si128((__m128i*)d, v);
+    unsigned char* dst = (unsigned char*)(((uintptr_t)d + 16) & ~(uintptr_t)15);
+    unsigned char* end = d + count;
+    while ((size_t)(end - dst) > 64) {
+        _mm_stream_si128((__m128i*)dst, v);
+        _mm_stream_si128((__m128i*)(dst + 16), v);
+        _mm_stream_si128((__m128i*)(dst + 32), v);
+        _mm_stream_si128((__m128i*)(dst + 48), v);
+        dst += 64;
+    }
+    _mm_sfence();
+
+    _mm_storeu_si128((__m128i*)(end - 64), v);
+    _mm_storeu_si128((__m128i*)(end - 48), v);
+    _mm_storeu_si128((__m128i*)(end - 32), v);
+    _mm_storeu_si128((__m128i*)(end - 16), v);
+    return dest;
+}
+
+__attribute__((target("avx2")))
+void* my_memcpy_avx2(void* dest, const void* src, size_t n) {
+    unsigned char* d = (unsigned char*)dest;
+    const unsigned char* s = (const unsigned char*)src;
+
+    if (n <= 32) {
+        if (n <= 16) {
+            return pbs_memcpy_small(dest, src, n);
+        }
+        __m128i a = _mm_loadu_si128((const __m128i*)s);
+        __m128i b = _mm_loadu_si128((const __m128i*)(s + n - 16));
+        _mm_storeu_si128((__m128i*)d, a);
+        _mm_storeu_si128((__m128i*)(d + n - 16), b);
+        return dest;
+    }
+    if (n <= 64) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)s);
+        __m256i b = _mm256_loadu_si256((const __m256i*)(s + n - 32));
+        _mm256_storeu_si256((__m256i*)d, a);
+        _mm256_storeu_si256((__m256i*)(d + n - 32), b);
+        return dest;
+    }
+    if (n <= 128) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)s);
+        __m256i b = _mm256_loadu_si256((const __m256i*)(s + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(s + n - 64));
+        __m256i e = _mm256_loadu_si256((const __m256i*)(s + n - 32));
+        _mm256_storeu_si256((__m256i*)d, a);
+        _mm256_storeu_si256((__m256i*)(d + 32), b);
+        _mm256_storeu_si256((__m256i*)(d + n - 64), c);
+        _mm256_storeu_si256((__m256i*)(d + n - 32), e);
+        return dest;
+    }
+
+    __m256i head = _mm256_loadu_si256((const __m256i*)s);
+    size_t skew = 32 - ((uintptr_t)d & 31);
+    unsigned char* dst = d + skew;
+    const unsigned char* src_p = s + skew;
+    size_t left = n - skew;
+
+    while (left > 128) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)src_p);
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src_p + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(src_p + 64));
+        __m256i e = _mm256_loadu_si256((const __m256i*)(src_p + 96));
+        _mm256_store_si256((__m256i*)dst, a);
+        _mm256_store_si256((__m256i*)(dst + 32), b);
+        _mm256_store_si256((__m256i*)(dst + 64), c);
+        _mm256_store_si256((__m256i*)(dst + 96), e);
+        dst += 128;
+        src_p += 128;
+        left -= 128;
+    }
+
+    __m256i a = _mm256_loadu_si256((const __m256i*)(s + n - 128));
+    __m256i b = _mm256_loadu_si256((const __m256i*)(s + n - 96));
+    __m256i c = _mm256_loadu_si256((const __m256i*)(s + n - 64));
+    __m256i e = _mm256_loadu_si256((const __m256i*)(s + n - 32));
+    _mm256_storeu_si256((__m256i*)(d + n - 128), a);
+    _mm256_storeu_si256((__m256i*)(d + n - 96), b);
+    _mm256_storeu_si256((__m256i*)(d + n - 64), c);
+    _mm256_storeu_si256((__m256i*)(d + n - 32), e);
+    _mm256_storeu_si256((__m256i*)d, head);
+    return dest;
+}
+
+__attribute__((target("avx2")))
+void* my_memset_avx2(void* dest, int value, size_t count) {
+    unsigned char* d = (unsigned char*)dest;
+
+    if (count <= 32) {
+        if (count <= 16) {
+            return pbs_memset_small(dest, value, count);
+        }
+        __m128i v = _mm_set1_epi8((char)value);
+        _mm_storeu_si128((__m128i*)d, v);
+        _mm_storeu_si128((__m128i*)(d + count - 16), v);
+        return dest;
+    }
+    __m256i v = _mm256_set1_epi8((char)value);
+    if (count <= 64) {
+        _mm256_storeu_si256((__m256i*)d, v);
+        _mm256_storeu_si256((__m256i*)(d + count - 32), v);
+        return dest;
+    }
+    if (count <= 128) {
+        _mm256_storeu_si256((__m256i*)d, v);
+        _mm256_storeu_si256((__m256i*)(d + 32), v);
+        _mm256_storeu_si256((__m256i*)(d + count - 64), v);
+        _mm256_storeu_si256((__m256i*)(d + count - 32), v);
+        return dest;
+    }
+
+    _mm256_storeu_si256((__m256i*)d, v);
+    unsigned char* dst = (unsigned char*)(((uintptr_t)d + 32) & ~(uintptr_t)31);
+    unsigned char* end = d + count;
+    while ((size_t)(end - dst) > 128) {
+        _mm256_store_si256((__m256i*)dst, v);
+        _mm256_store_si256((__m256i*)(dst + 32), v);
+        _mm256_store_si256((__m256i*)(dst + 64), v);
+        _mm256_store_si256((__m256i*)(dst + 96), v);
+        dst += 128;
+    }
+    _mm256_storeu_si256((__m256i*)(end - 128), v);
+    _mm256_storeu_si256((__m256i*)(end - 96), v);
+    _mm256_storeu_si256((__m256i*)(end - 64), v);
+    _mm256_storeu_si256((__m256i*)(end - 32), v);
+    return dest;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// 统一入口的分派：CPU 特性只检测一次，按大小分三档
+// ---------------------------------------------------------------------------
+
+#if defined(__aarch64__) && defined(__linux__) && !defined(HWCAP_ASIMD)
+#define HWCAP_ASIMD (1UL << 1)
+#endif
+
+static unsigned detect_cpu_features(void) {
+    unsigned features = 0;
+#if defined(__aarch64__) && defined(__linux__)
+    // Linux 用户态不能直接读 ID 寄存器，由内核通过 HWCAP 报告
+    if (getauxval(AT_HWCAP) & HWCAP_ASIMD) {
+        features |= PBS_CPU_ASIMD;
+    }
+#elif defined(__aarch64__)
+    // 裸机（EL1）：ID_AA64PFR0_EL1.AdvSIMD（位 [23:20]）为 0xF 表示未实现
+    uint64_t pfr0;
+    __asm__ volatile("mrs %0, id_aa64pfr0_el1" : "=r"(pfr0));
+    if (((pfr0 >> 20) & 0xF) != 0xF) {
+        features |= PBS_CPU_ASIMD;
+    }
+#elif defined(__x86_64__)
+    features |= PBS_CPU_SSE2;
+    // __builtin_cpu_supports 同时检查操作系统是否保存 YMM 状态
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        features |= PBS_CPU_AVX2;
+    }
+#endif
+    return features;
+}
+
+// 最大一级数据（或统一）缓存的字节数，检测不到时返回 0
+static size_t detect_cache_size(void) {
+    size_t best = 0;
+#if defined(__x86_64__)
+    // CPUID 叶 4（Intel）或 0x8000001D（AMD）逐级列出缓存参数
+    unsigned eax, ebx, ecx, edx;
+    unsigned leaf = 0;
+    if (__get_cpuid(0, &eax, &ebx, &ecx, &edx) && eax >= 4 && ebx != 0x68747541) {
+        leaf = 4;
+    } else if (__get_cpuid_max(0x80000000, NULL) >= 0x8000001D) {
+        leaf = 0x8000001D;
+    }
+    for (unsigned i = 0; leaf != 0 && i < 16; i++) {
+        __cpuid_count(leaf, i, eax, ebx, ecx, edx);
+        unsigned type = eax & 0x1F;  // 0 结束，1 数据，2 指令，3 统一
+        if (type == 0) {
+            break;
+        }
+        if (type == 2) {
+            continue;
+        }
+        size_t size = (size_t)(((ebx >> 22) & 0x3FF) + 1) * (((ebx >> 12) & 0x3FF) + 1) *
+                      ((ebx & 0xFFF) + 1) * ((size_t)ecx + 1);
+        if (size > best) {
+            best = size;
+        }
+    }
+#elif defined(__aarch64__) && defined(__linux__)
+    long size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (size <= 0) {
+        size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    }
+    if (size > 0) {
+        best = (size_t)size;
+    }
+#elif defined(__aarch64__)
+    // 裸机（EL1）：CLIDR_EL1 列出各级缓存类型，CSSELR_EL1 选择一级后从 CCSIDR_EL1 读取几何参数
+    uint64_t clidr;
+    __asm__ volatile("mrs %0, clidr_el1" : "=r"(clidr));
+    for (unsigned level = 0; level < 7; level++) {
+        unsigned ctype = (clidr >> (3 * level)) & 7;  // 0 无，1 仅指令，2 数据，3 分离，4 统一
+        if (ctype == 0) {
+            break;
+        }
+        if (ctype == 1) {
+            continue;
+        }
+        uint64_t ccsidr;
+        __asm__ volatile("msr csselr_el1, %1\n\tisb\n\tmrs %0, ccsidr_el1"
+                         : "=r"(ccsidr) : "r"((uint64_t)level << 1));
+        size_t line = (size_t)16 << (ccsidr & 7);
+        size_t ways = ((ccsidr >> 3) & 0x3FF) + 1;
+        size_t sets = ((ccsidr >> 13) & 0x7FFF) + 1;
+        if (line * ways * sets > best) {
+            best = line * ways * sets;
+        }
+    }
+#endif
+    return best;
+}
+
+// 流式阈值：编译时给定则直接使用，否则取末级缓存的 3/4，
+// 超过这个大小的复制/填充无论如何都装不进缓存，绕过缓存不会损失命中
+static size_t stream_threshold(size_t configured, size_t cache_size) {
+    if (configured != 0) {
+        return configured;
+    }
+    if (cache_size == 0) {
+        cache_size = PBS_CACHE_SIZE_DEFAULT;
+    }
+    return cache_size / 4 * 3;
+}
+
+static void memory_ops_select(pbs_memory_ops* ops) {
+    ops->features = detect_cpu_features();
+    ops->cache_size = detect_cache_size();
+    ops->copy_large_min = stream_threshold(PBS_MEMCPY_LARGE, ops->cache_size);
+    ops->set_large_min = stream_threshold(PBS_MEMSET_LARGE, ops->cache_size);
+    ops->copy_medium = my_memcpy_word;
+    ops->copy_large = my_memcpy_word;
+    ops->set_medium = my_memset;
+    ops->set_large = my_memset;
+    ops->move = my_memmove;
+#if defined(__aarch64__) && defined(__ARM_NEON)
+    if (ops->features & PBS_CPU_ASIMD) {
+        ops->copy_medium = my_memcpy_neon;
+        ops->copy_large = my_memcpy_neon;
+        ops->set_medium = my_memset_neon;
+        ops->set_large = my_memset_neon;
+        ops->move = my_memmove_neon;
+#if PBS_HAVE_ASM
+        ops->copy_medium = my_memcpy_asm;
+        ops->copy_large = my_memcpy_stream_asm;
+        ops->set_large = my_memset_stream_asm;
+#endif
+    }
+#elif defined(__x86_64__)
+    if (ops->features & PBS_CPU_AVX2) {
+        ops->copy_medium = my_memcpy_avx2;
+        ops->set_medium = my_memset_avx2;
+    } else {
+        ops->copy_medium = my_memcpy_sse2;
+        ops->set_medium = my_memset_sse2;
+    }
+    ops->copy_large = my_memcpy_stream_sse2;
+    ops->set_large = my_memset_stream_sse2;
+    ops->move = my_memmove_sse2;
+#endif
+}
+
+const pbs_copy_variant pbs_memcpy_variants[] = {
+    { "basic", my_memcpy_basic, 0 },
+    { "aligned", my_memcpy, 0 },
+    { "fast", my_memcpy_fast, 0 },
+    { "word", my_memcpy_word, 0 },
+#if defined(__aarch64__) && defined(__ARM_NEON)
+    { "neon", my_memcpy_neon, PBS_CPU_ASIMD },
+#endif
+#if defined(__x86_64__)
+    { "sse2", my_memcpy_sse2, PBS_CPU_SSE2 },
+    { "avx2", my_memcpy_avx2, PBS_CPU_AVX2 },
+    { "stream-sse2", my_memcpy_stream_sse2, PBS_CPU_SSE2 },
+#endif
+#if defined(__aarch64__) && PBS_HAVE_ASM
+    { "asm", my_memcpy_asm, PBS_CPU_ASIMD },
+    { "ext-asm", my_memcpy_ext_asm, PBS_CPU_ASIMD },
+    { "stream-asm", my_memcpy_stream_asm, PBS_CPU_ASIMD },
+#endif
+    { "dispatch", pbs_memcpy_dispatch, 0 },
+};
+const size_t pbs_memcpy_variant_count = sizeof(pbs_memcpy_variants) / sizeof(pbs_memcpy_variants[0]);
+
+const pbs_copy_variant pbs_memmove_variants[] = {
+    { "word", my_memmove, 0 },
+#if defined(__aarch64__) && defined(__ARM_NEON)
+    { "neon", my_memmove_neon, PBS_CPU_ASIMD },
+#endif
+#if defined(__aarch64__) && PBS_HAVE_ASM
+    { "asm", my_memmove_asm, PBS_CPU_ASIMD },
+#endif
+#if defined(__x86_64__)
+    { "sse2", my_memmove_sse2, PBS_CPU_SSE2 },
+#endif
+    { "dispatch", pbs_memmove_dispatch, 0 },
+};
+const size_t pbs_memmove_variant_count = sizeof(pbs_memmove_variants) / sizeof(pbs_memmove_variants[0]);
+
+const pbs_set_variant pbs_memset_variants[] = {
+    { "basic", my_memset_basic, 0 },
+    { "word", my_memset, 0 },
+#if defined(__aarch64__) && defined(__ARM_NEON)
+    { "neon", my_memset_neon, PBS_CPU_ASIMD },
+#endif
+#if defined(__x86_64__)
+    { "sse2", my_memset_sse2, PBS_CPU_SSE2 },
+    { "avx2", my_memset_avx2, PBS_CPU_AVX2 },
+    { "stream-sse2", my_memset_stream_sse2, PBS_CPU_SSE2 },
+#endif
+#if defined(__aarch64__) && PBS_HAVE_ASM
+    { "asm", my_memset_asm, 0 },
+    { "stream-asm", my_memset_stream_asm, PBS_CPU_ASIMD },
+#endif
+    { "dispatch", pbs_memset_dispatch, 0 },
+};
+const size_t pbs_memset_variant_count = sizeof(pbs_memset_variants) / sizeof(pbs_memset_variants[0]);
+
+static pbs_memory_ops memory_ops;
+static int memory_ops_state;  // 0 未初始化，1 初始化中，2 就绪
+
+// 首次调用时选择实现；并发的首次调用者等待初始化完成
+const pbs_memory_ops* pbs_memory_ops_get(void) {
+    if (__atomic_load_n(&memory_ops_state, __ATOMIC_ACQUIRE) != 2) {
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&memory_ops_state, &expected, 1, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            memory_ops_select(&memory_ops);
+            __atomic_store_n(&memory_ops_state, 2, __ATOMIC_RELEASE);
+        } else {
+            while (__atomic_load_n(&memory_ops_state, __ATOMIC_ACQUIRE) != 2) {
+            }
+        }
+    }
+    return &memory_ops;
+}
+
+unsigned pbs_cpu_features(void) {
+    return pbs_memory_ops_get()->features;
+}
+
+void* pbs_memcpy_dispatch(void* dest, const void* src, size_t n) {
+    const pbs_memory_ops* ops = pbs_memory_ops_get();
+    if (n >= ops->copy_large_min) {
+        return ops->copy_large(dest, src, n);
+    }
+    return ops->copy_medium(dest, src, n);
+}
+
+void* pbs_memmove_dispatch(void* dest, const void* src, size_t n) {
+    return pbs_memory_ops_get()->move(dest, src, n);
+}
+
+void* pbs_memset_dispatch(void* dest, int value, size_t n) {
+    const pbs_memory_ops* ops = pbs_memory_ops_get();
+    if (n >= ops->set_large_min) {
+        return ops->set_large(dest, value, n);
+    }
+    return ops->set_medium(dest, value, n);
+}
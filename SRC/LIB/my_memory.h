@@ -0,0 +1,203 @@
+#ifndef MY_MEMORY_H
+#define MY_MEMORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 分派阈值（字节），可在编译时用 -D 覆盖：不超过 INLINE_MAX 的请求在调用处内联完成，
+// 达到 LARGE 的请求交给绕过缓存的流式实现，其余交给中等大小的实现。
+// LARGE 为 0 时在启动时取末级缓存大小的 3/4（检测不到缓存时按 PBS_CACHE_SIZE_DEFAULT）。
+// make bench-mem 测得的阈值写在生成目录的 pbs_memory_tuned.h 中，存在时优先于下面的默认值
+#if defined(__has_include)
+#if __has_include("pbs_memory_tuned.h")
+#include "pbs_memory_tuned.h"
+#endif
+#endif
+#ifndef PBS_MEMCPY_INLINE_MAX
+#define PBS_MEMCPY_INLINE_MAX 16
+#endif
+#ifndef PBS_MEMCPY_LARGE
+#define PBS_MEMCPY_LARGE 0
+#endif
+#ifndef PBS_MEMSET_INLINE_MAX
+#define PBS_MEMSET_INLINE_MAX 16
+#endif
+#ifndef PBS_MEMSET_LARGE
+#define PBS_MEMSET_LARGE 0
+#endif
+#ifndef PBS_CACHE_SIZE_DEFAULT
+#define PBS_CACHE_SIZE_DEFAULT (1024 * 1024)
+#endif
+
+#if PBS_MEMCPY_INLINE_MAX > 32 || PBS_MEMSET_INLINE_MAX > 32
+#error "内联阈值不能超过 32 字节"
+#endif
+
+// 为 1 时链接 my_memory.s 中的汇编实现（Makefile 在 AArch64 目标上定义）
+#ifndef PBS_HAVE_ASM
+#define PBS_HAVE_ASM 0
+#endif
+
+// CPU 特性位，启动后检测一次
+#define PBS_CPU_ASIMD (1u << 0)  // AArch64 Advanced SIMD（NEON）
+#define PBS_CPU_SSE2  (1u << 1)  // x86-64 基线
+#define PBS_CPU_AVX2  (1u << 2)
+
+typedef void *(*pbs_copy_fn)(void *dest, const void *src, size_t n);
+typedef void *(*pbs_set_fn)(void *dest, int value, size_t n);
+
+// 分派表：首次使用时按 CPU 特性填充，之后只读
+typedef struct {
+    unsigned features;
+    size_t cache_size;       // 检测到的最大一级缓存，0 表示未知
+    size_t copy_large_min;   // 不小于此值的复制走 copy_large
+    size_t set_large_min;
+    pbs_copy_fn copy_medium;
+    pbs_copy_fn copy_large;
+    pbs_set_fn set_medium;
+    pbs_set_fn set_large;
+    pbs_copy_fn move;
+} pbs_memory_ops;
+
+unsigned pbs_cpu_features(void);
+const pbs_memory_ops *pbs_memory_ops_get(void);
+void *pbs_memcpy_dispatch(void *dest, const void *src, size_t n);  // 超出内联阈值的请求
+void *pbs_memmove_dispatch(void *dest, const void *src, size_t n);
+void *pbs_memset_dispatch(void *dest, int value, size_t n);
+
+// 不超过 32 字节的复制：首尾两次重叠的定长访问覆盖全部，无循环。
+// 所有读取都在写入之前完成，源与目标重叠时同样正确
+static inline void *pbs_memcpy_small(void *dest, const void *src, size_t n) {
+    unsigned char *d = (unsigned char *)dest;
+    const unsigned char *s = (const unsigned char *)src;
+    if (n >= 16) {
+        uint64_t a, b, c, e;
+        __builtin_memcpy(&a, s, 8);
+        __builtin_memcpy(&b, s + 8, 8);
+        __builtin_memcpy(&c, s + n - 16, 8);
+        __builtin_memcpy(&e, s + n - 8, 8);
+        __builtin_memcpy(d, &a, 8);
+        __builtin_memcpy(d + 8, &b, 8);
+        __builtin_memcpy(d + n - 16, &c, 8);
+        __builtin_memcpy(d + n - 8, &e, 8);
+    } else if (n >= 8) {
+        uint64_t a, b;
+        __builtin_memcpy(&a, s, 8);
+        __builtin_memcpy(&b, s + n - 8, 8);
+        __builtin_memcpy(d, &a, 8);
+        __builtin_memcpy(d + n - 8, &b, 8);
+    } else if (n >= 4) {
+        uint32_t a, b;
+        __builtin_memcpy(&a, s, 4);
+        __builtin_memcpy(&b, s + n - 4, 4);
+        __builtin_memcpy(d, &a, 4);
+        __builtin_memcpy(d + n - 4, &b, 4);
+    } else if (n > 0) {
+        // 1~3 字节：首、中、尾三个位置覆盖全部
+        unsigned char a = s[0], b = s[n / 2], c = s[n - 1];
+        d[0] = a;
+        d[n / 2] = b;
+        d[n - 1] = c;
+    }
+    return dest;
+}
+
+static inline void *pbs_memset_small(void *dest, int value, size_t n) {
+    unsigned char *d = (unsigned char *)dest;
+    uint64_t v = (uint64_t)(unsigned char)value * 0x0101010101010101ULL;
+    if (n >= 16) {
+        __builtin_memcpy(d, &v, 8);
+        __builtin_memcpy(d + 8, &v, 8);
+        __builtin_memcpy(d + n - 16, &v, 8);
+        __builtin_memcpy(d + n - 8, &v, 8);
+    } else if (n >= 8) {
+        __builtin_memcpy(d, &v, 8);
+        __builtin_memcpy(d + n - 8, &v, 8);
+    } else if (n >= 4) {
+        uint32_t w = (uint32_t)v;
+        __builtin_memcpy(d, &w, 4);
+        __builtin_memcpy(d + n - 4, &w, 4);
+    } else if (n > 0) {
+        d[0] = (unsigned char)value;
+        d[n / 2] = (unsigned char)value;
+        d[n - 1] = (unsigned char)value;
+    }
+    return dest;
+}
+
+// 统一入口：小块在调用处内联完成，不经过函数指针
+static inline void *pbs_memcpy(void *dest, const void *src, size_t n) {
+    if (n > PBS_MEMCPY_INLINE_MAX) {
+        return pbs_memcpy_dispatch(dest, src, n);
+    }
+    return pbs_memcpy_small(dest, src, n);
+}
+
+// 源与目标可以重叠，小块的处理与 pbs_memcpy 相同
+static inline void *pbs_memmove(void *dest, const void *src, size_t n) {
+    if (n > PBS_MEMCPY_INLINE_MAX) {
+        return pbs_memmove_dispatch(dest, src, n);
+    }
+    return pbs_memcpy_small(dest, src, n);
+}
+
+static inline void *pbs_memset(void *dest, int value, size_t n) {
+    if (n > PBS_MEMSET_INLINE_MAX) {
+        return pbs_memset_dispatch(dest, value, n);
+    }
+    return pbs_memset_small(dest, value, n);
+}
+
+// 各实现，分派表从中选择，也可直接调用做对比
+void *my_memcpy_basic(void *dest, const void *src, size_t n);
+void *my_memcpy(void *dest, const void *src, size_t n);
+void *my_memcpy_fast(void *dest, const void *src, size_t n);
+void *my_memcpy_word(void *dest, const void *src, size_t n);
+void *my_memmove(void *dest, const void *src, size_t n);
+void *my_memset_basic(void *dest, int value, size_t count);
+void *my_memset(void *dest, int value, size_t count);
+#if defined(__aarch64__) && defined(__ARM_NEON)
+void *my_memcpy_neon(void *dest, const void *src, size_t n);
+void *my_memset_neon(void *dest, int value, size_t count);
+void *my_memmove_neon(void *dest, const void *src, size_t n);
+#endif
+#if defined(__aarch64__) && PBS_HAVE_ASM
+void *my_memcpy_asm(void *dest, const void *src, size_t n);       // 非对齐加载 + 对齐存储
+void *my_memcpy_ext_asm(void *dest, const void *src, size_t n);   // 对齐加载 + EXT 拼接
+void *my_memset_asm(void *dest, int value, size_t count);
+void *my_memmove_asm(void *dest, const void *src, size_t n);
+void *my_memcpy_stream_asm(void *dest, const void *src, size_t n);   // STNP
+void *my_memset_stream_asm(void *dest, int value, size_t count);     // STNP，填零时用 DC ZVA
+#endif
+#if defined(__x86_64__)
+void *my_memcpy_sse2(void *dest, const void *src, size_t n);
+void *my_memset_sse2(void *dest, int value, size_t count);
+void *my_memmove_sse2(void *dest, const void *src, size_t n);
+void *my_memcpy_stream_sse2(void *dest, const void *src, size_t n);  // movntdq + sfence
+void *my_memset_stream_sse2(void *dest, int value, size_t count);
+void *my_memcpy_avx2(void *dest, const void *src, size_t n);  // 需要 PBS_CPU_AVX2
+void *my_memset_avx2(void *dest, int value, size_t count);
+#endif
+
+// 变体表：列出本架构编译进来的全部实现，requires 为运行所需的 CPU 特性位，
+// 基准测试逐个遍历，跳过当前 CPU 不支持的项
+typedef struct {
+    const char *name;
+    pbs_copy_fn fn;
+    unsigned requires;
+} pbs_copy_variant;
+
+typedef struct {
+    const char *name;
+    pbs_set_fn fn;
+    unsigned requires;
+} pbs_set_variant;
+
+extern const pbs_copy_variant pbs_memcpy_variants[];
+extern const size_t pbs_memcpy_variant_count;
+extern const pbs_copy_variant pbs_memmove_variants[];
+extern const size_t pbs_memmove_variant_count;
+extern const pbs_set_variant pbs_memset_variants[];
+extern const size_t pbs_memset_variant_count;
+
+#endif // MY_MEMORY_H
@@ -9,122 +9,67 @@
 .global my_memset_asm
 .type my_memset_asm, %function
 
+.global my_memmove_asm
+.type my_memmove_asm, %function
+
+.global my_memcpy_stream_asm
+.type my_memcpy_stream_asm, %function
+
+.global my_memset_stream_asm
+.type my_memset_stream_asm, %function
+
+.global my_memcpy_ext_asm
+.type my_memcpy_ext_asm, %function
+
 my_memcpy_asm:
     // 参数:
-    // x0 - 目标地址
+    // x0 - 目标地址（返回值，不修改）
     // x1 - 源地址
     // x2 - 复制长度
     
-    // 如果长度为0，直接返回
-    cbz x2, .Lexit
-    
-    // 保存寄存器
-    stp x3, x4, [sp, -16]!
-    stp x5, x6, [sp, -16]!
-    stp x7, x8, [sp, -16]!
-    stp x9, x10, [sp, -16]!
-    
-    mov x3, x0  // 保存目标地址
-    
-    // 检查重叠
-    cmp x0, x1
-    b.hi .Lcheck_overlap
-    b .Lcopy_forward
-    
-.Lcheck_overlap:
-    add x4, x1, x2
-    cmp x0, x4
-    b.lo .Lcopy_backward  // 如果目标在源范围内，向后复制
-    
-.Lcopy_forward:
-    // 复制前面对齐部分
-    tst x0, #7
-    b.eq .Laligned_dest
-    
-.Lalign_dest:
-    tst x0, #7
-    b.eq .Laligned_dest
-    ldrb w4, [x1], #1
-    strb w4, [x0], #1
-    subs x2, x2, #1
-    b.eq .Lexit_restore
-    b .Lalign_dest
-    
-.Laligned_dest:
-    // 检查源地址是否对齐
-    tst x1, #7
-    b.eq .Laligned_both
-    
-    // 源未对齐，使用字节复制
-    cmp x2, #64
-    b.lo .Lbyte_copy
-    
-.Lunaligned_src:
-    // 使用非对齐加载和对齐存储
-    ldp x4, x5, [x1], #16
-    ldp x6, x7, [x1], #16
-    stp x4, x5, [x0], #16
-    stp x6, x7, [x0], #16
-    subs x2, x2, #32
-    b.hi .Lunaligned_src
-    b .Lbyte_copy
-    
-.Laligned_both:
-    // 两者都已对齐，使用64位复制
+    // 64 字节以内，或目标在源之后且重叠时，交给 my_memmove_asm
+    sub x3, x0, x1
+    cmp x3, x2
+    b.lo .Lcopy_memmove
     cmp x2, #64
-    b.lo .Lword_copy
-    
-.Lvector_copy:
-    // 使用多寄存器加载/存储
-    ldp x4, x5, [x1], #16
-    ldp x6, x7, [x1], #16
-    ldp x8, x9, [x1], #16
-    ldp x10, x11, [x1], #16
-    stp x4, x5, [x0], #16
-    stp x6, x7, [x0], #16
-    stp x8, x9, [x0], #16
-    stp x10, x11, [x0], #16
-    subs x2, x2, #64
-    b.hi .Lvector_copy
-    
-.Lword_copy:
-    // 复制剩余的字
-    cmp x2, #8
-    b.lo .Lbyte_copy
-    ldr x4, [x1], #8
-    str x4, [x0], #8
-    subs x2, x2, #8
-    b.hi .Lword_copy
-    
-.Lbyte_copy:
-    // 复制剩余的字节
-    cbz x2, .Lexit_restore
-    ldrb w4, [x1], #1
-    strb w4, [x0], #1
-    subs x2, x2, #1
-    b.hi .Lbyte_copy
-    b .Lexit_restore
+    b.ls .Lcopy_memmove
     
-.Lcopy_backward:
-    // 从后向前复制
-    add x0, x0, x2
-    add x1, x1, x2
+    // 源地址任意对齐：非对齐加载，按目标 16 字节对齐存储，速度与相对错位无关。
+    // 头部 16 字节和尾部 64 字节先读出、最后写入，循环在剩余不超过 64 字节时结束，
+    // 读写都不会越过源或目标的末尾
+    add x5, x1, x2          // 源结束地址
+    add x6, x0, x2          // 目标结束地址
+    ldr q4, [x1]
+    ldp q0, q1, [x5, #-64]
+    ldp q2, q3, [x5, #-32]
+    and x4, x0, #15
+    mov x7, #16
+    sub x4, x7, x4          // 到下一个 16 字节边界的距离（1~16）
+    add x8, x0, x4
+    add x9, x1, x4
+    sub x10, x2, x4
+    cmp x10, #64
+    b.ls .Lcopy_tail
     
-.Lbyte_copy_backward:
-    ldrb w4, [x1, #-1]!
-    strb w4, [x0, #-1]!
-    subs x2, x2, #1
-    b.hi .Lbyte_copy_backward
+.Lcopy_loop:
+    ldp q16, q17, [x9]
+    ldp q18, q19, [x9, #32]
+    add x9, x9, #64
+    sub x10, x10, #64
+    stp q16, q17, [x8]
+    stp q18, q19, [x8, #32]
+    add x8, x8, #64
+    cmp x10, #64
+    b.hi .Lcopy_loop
     
-.Lexit_restore:
-    // 恢复寄存器
-    ldp x9, x10, [sp], 16
-    ldp x7, x8, [sp], 16
-    ldp x5, x6, [sp], 16
-    ldp x3, x4, [sp], 16
-    
-.Lexit:
+.Lcopy_tail:
+    stp q0, q1, [x6, #-64]
+    stp q2, q3, [x6, #-32]
+    str q4, [x0]
     ret
+    
+.Lcopy_memmove:
+    b my_memmove_asm
 
 .size my_memcpy_asm, .-my_memcpy_asm
 
@@ -138,7 +83,7 @@ my_memset_asm:
     // x2 - 填充长度
     
     // 如果长度为0，直接返回
-    cbz x2, .Lexit
+    cbz x2, .Lset_exit
     
     // 保存寄存器
     stp x3, x4, [sp, -16]!
@@ -156,22 +101,22 @@ my_memset_asm:
     
     // 复制前面对齐部分
     tst x0, #7
-    b.eq .Laligned_dest
+    b.eq .Lset_aligned_dest
     
-.Lalign_dest:
+.Lset_align_dest:
     tst x0, #7
-    b.eq .Laligned_dest
+    b.eq .Lset_aligned_dest
     strb w1, [x0], #1
     subs x2, x2, #1
-    b.eq .Lexit_restore
-    b .Lalign_dest
+    b.eq .Lset_exit_restore
+    b .Lset_align_dest
     
-.Laligned_dest:
+.Lset_aligned_dest:
     // 使用64位字填充
     cmp x2, #64
-    b.lo .Lword_copy
+    b.lo .Lset_word_copy
     
-.Lvector_copy:
+.Lset_vector_copy:
     // 使用多寄存器存储
     mov x5, x3
     mov x6, x3
@@ -182,31 +127,411 @@ my_memset_asm:
     stp x7, x8, [x0], #16
     stp x5, x6, [x0], #16
     stp x7, x8, [x0], #16
-    subs x2, x2, #64
-    b.hi .Lvector_copy
+    sub x2, x2, #64
+    cmp x2, #64
+    b.hs .Lset_vector_copy
     
-.Lword_copy:
+.Lset_word_copy:
     // 复制剩余的字
     cmp x2, #8
-    b.lo .Lbyte_copy
+    b.lo .Lset_byte_copy
     str x3, [x0], #8
     subs x2, x2, #8
-    b.hi .Lword_copy
+    b.hi .Lset_word_copy
     
-.Lbyte_copy:
+.Lset_byte_copy:
     // 复制剩余的字节
-    cbz x2, .Lexit_restore
+    cbz x2, .Lset_exit_restore
     strb w1, [x0], #1
     subs x2, x2, #1
-    b.hi .Lbyte_copy
+    b.hi .Lset_byte_copy
     
-.Lexit_restore:
-    // 恢复寄存器
+.Lset_exit_restore:
+    // 恢复寄存器，返回原目标地址
+    mov x0, x4
     ldp x7, x8, [sp], 16
     ldp x5, x6, [sp], 16
     ldp x3, x4, [sp], 16
     
-.Lexit:
+.Lset_exit:
+    ret
+
+.size my_memset_asm, .-my_memset_asm
+
+// my_memmove_asm
+// 重叠安全的复制，两个方向都用 128 位寄存器成对加载/存储。
+// 首尾在主循环之前读出、最后写入，主循环读取的源数据总在已写入的目标范围之外；
+// 主体按目标地址 16 字节对齐存储
+
+my_memmove_asm:
+    // 参数:
+    // x0 - 目标地址（返回值，不修改）
+    // x1 - 源地址
+    // x2 - 复制长度
+    sub x3, x0, x1          // 目标与源的距离
+    cbz x3, .Lmove_done
+    add x5, x1, x2          // 源结束地址
+    add x6, x0, x2          // 目标结束地址
+    cmp x2, #16
+    b.ls .Lmove_16
+    cmp x2, #64
+    b.ls .Lmove_64
+    cmp x3, x2
+    b.lo .Lmove_backward    // 0 < 目标 - 源 < 长度：目标在源之后且重叠
+
+    // 正向：头部 16 字节和尾部 64 字节先读出
+    ldr q4, [x1]
+    ldp q0, q1, [x5, #-64]
+    ldp q2, q3, [x5, #-32]
+    and x4, x0, #15
+    mov x7, #16
+    sub x4, x7, x4          // 到下一个 16 字节边界的距离（1~16）
+    add x8, x0, x4
+    add x9, x1, x4
+    sub x10, x2, x4
+    cmp x10, #64
+    b.ls .Lforward_tail
+
+.Lforward_loop:
+    ldp q16, q17, [x9]
+    ldp q18, q19, [x9, #32]
+    add x9, x9, #64
+    sub x10, x10, #64
+    stp q16, q17, [x8]
+    stp q18, q19, [x8, #32]
+    add x8, x8, #64
+    cmp x10, #64
+    b.hi .Lforward_loop
+
+.Lforward_tail:
+    stp q0, q1, [x6, #-64]
+    stp q2, q3, [x6, #-32]
+    str q4, [x0]
+    ret
+
+.Lmove_backward:
+    // 反向：头部 64 字节和尾部 16 字节先读出
+    ldp q0, q1, [x1]
+    ldp q2, q3, [x1, #32]
+    ldr q4, [x5, #-16]
+    and x4, x6, #15         // 目标结束地址超出 16 字节边界的部分（0~15）
+    sub x8, x6, x4
+    sub x9, x5, x4
+    sub x10, x2, x4
+    cmp x10, #64
+    b.ls .Lbackward_head
+
+.Lbackward_loop:
+    ldp q16, q17, [x9, #-64]
+    ldp q18, q19, [x9, #-32]
+    sub x9, x9, #64
+    sub x10, x10, #64
+    stp q16, q17, [x8, #-64]
+    stp q18, q19, [x8, #-32]
+    sub x8, x8, #64
+    cmp x10, #64
+    b.hi .Lbackward_loop
+
+.Lbackward_head:
+    stp q0, q1, [x0]
+    stp q2, q3, [x0, #32]
+    str q4, [x6, #-16]
+    ret
+
+.Lmove_64:
+    // 17~64 字节：首尾各 16 或 32 字节
+    cmp x2, #32
+    b.hi .Lmove_33_64
+    ldr q0, [x1]
+    ldr q1, [x5, #-16]
+    str q0, [x0]
+    str q1, [x6, #-16]
+    ret
+
+.Lmove_33_64:
+    ldp q0, q1, [x1]
+    ldp q2, q3, [x5, #-32]
+    stp q0, q1, [x0]
+    stp q2, q3, [x6, #-32]
+    ret
+
+.Lmove_16:
+    // 0~16 字节：先全部读出再写入
+    cmp x2, #8
+    b.lo .Lmove_7
+    ldr x7, [x1]
+    ldr x8, [x5, #-8]
+    str x7, [x0]
+    str x8, [x6, #-8]
+    ret
+
+.Lmove_7:
+    cmp x2, #4
+    b.lo .Lmove_3
+    ldr w7, [x1]
+    ldr w8, [x5, #-4]
+    str w7, [x0]
+    str w8, [x6, #-4]
+    ret
+
+.Lmove_3:
+    cbz x2, .Lmove_done
+    lsr x9, x2, #1
+    ldrb w7, [x1]
+    ldrb w8, [x1, x9]
+    ldrb w10, [x5, #-1]
+    strb w7, [x0]
+    strb w8, [x0, x9]
+    strb w10, [x6, #-1]
+
+.Lmove_done:
+    ret
+
+.size my_memmove_asm, .-my_memmove_asm
+
+// my_memcpy_stream_asm
+// 大块复制：主体用 STNP 非临时存储写出，数据不在缓存中驻留，不挤占工作集。
+// 头部 16 字节和尾部 64 字节先读出，最后用普通存储写入；小于 128 字节交给 my_memmove_asm
+
+my_memcpy_stream_asm:
+    // 参数:
+    // x0 - 目标地址（返回值，不修改）
+    // x1 - 源地址
+    // x2 - 复制长度
+    cmp x2, #128
+    b.hs .Lstream_copy
+    b my_memmove_asm
+
+.Lstream_copy:
+    add x5, x1, x2          // 源结束地址
+    add x6, x0, x2          // 目标结束地址
+    ldr q4, [x1]
+    ldp q0, q1, [x5, #-64]
+    ldp q2, q3, [x5, #-32]
+    and x4, x0, #15
+    mov x7, #16
+    sub x4, x7, x4          // 到下一个 16 字节边界的距离（1~16）
+    add x8, x0, x4
+    add x9, x1, x4
+    sub x10, x2, x4         // 剩余长度，至少 112
+
+.Lstream_copy_loop:
+    ldp q16, q17, [x9]
+    ldp q18, q19, [x9, #32]
+    add x9, x9, #64
+    sub x10, x10, #64
+    stnp q16, q17, [x8]
+    stnp q18, q19, [x8, #32]
+    add x8, x8, #64
+    cmp x10, #64
+    b.hi .Lstream_copy_loop
+
+    stp q0, q1, [x6, #-64]
+    stp q2, q3, [x6, #-32]
+    str q4, [x0]
+    ret
+
+.size my_memcpy_stream_asm, .-my_memcpy_stream_asm
+
+// my_memset_stream_asm
+// 大块填充：填零且 DCZID_EL0 允许时按块用 DC ZVA 清零（不读取原有内容），
+// 否则主体用 STNP 非临时存储；首尾 64 字节用普通存储
+
+my_memset_stream_asm:
+    // 参数:
+    // x0 - 目标地址（返回值，不修改）
+    // w1 - 填充值（低8位有效）
+    // x2 - 填充长度
+    dup v0.16b, w1
+    add x6, x0, x2          // 目标结束地址
+    cmp x2, #128
+    b.lo .Lstream_set_small
+
+    stp q0, q0, [x0]
+    stp q0, q0, [x0, #32]
+    tst w1, #0xff
+    b.ne .Lstream_set_nt
+    mrs x3, dczid_el0
+    tbnz w3, #4, .Lstream_set_nt    // DZP：禁止使用 DC ZVA
+    and w3, w3, #15
+    mov x4, #4
+    lsl x4, x4, x3          // 清零块大小（字节）
+    cmp x4, #64
+    b.lo .Lstream_set_nt
+    cmp x2, x4, lsl #1
+    b.lo .Lstream_set_nt    // 至少要覆盖两个块，保证对齐后仍有完整的块
+
+    // 首个块边界之前的部分按 64 字节补齐（开头 64 字节已写）
+    sub x5, x4, #1
+    add x8, x0, x5
+    bic x8, x8, x5          // 第一个块边界
+    and x9, x0, #-64
+    add x9, x9, #64
+.Lzva_head:
+    cmp x9, x8
+    b.hs .Lzva_loop_check
+    stp q0, q0, [x9]
+    stp q0, q0, [x9, #32]
+    add x9, x9, #64
+    b .Lzva_head
+
+.Lzva_loop:
+    dc zva, x8
+    add x8, x8, x4
+.Lzva_loop_check:
+    add x9, x8, x4
+    cmp x9, x6
+    b.ls .Lzva_loop
+
+    // 最后一个块边界之后不足一块的部分
+.Lzva_tail:
+    add x9, x8, #64
+    cmp x9, x6
+    b.hi .Lstream_set_end
+    stp q0, q0, [x8]
+    stp q0, q0, [x8, #32]
+    mov x8, x9
+    b .Lzva_tail
+
+.Lstream_set_nt:
+    and x8, x0, #-64
+    add x8, x8, #64         // 开头 64 字节已写，从下一个 64 字节边界开始
+    sub x10, x6, #64        // 最后 64 字节单独写
+.Lstream_set_loop:
+    cmp x8, x10
+    b.hs .Lstream_set_end
+    stnp q0, q0, [x8]
+    stnp q0, q0, [x8, #32]
+    add x8, x8, #64
+    b .Lstream_set_loop
+
+.Lstream_set_end:
+    stp q0, q0, [x6, #-64]
+    stp q0, q0, [x6, #-32]
+    ret
+
+.Lstream_set_small:
+    // 0~127 字节：首尾重叠存储
+    cmp x2, #32
+    b.ls .Lstream_set_32
+    stp q0, q0, [x0]
+    stp q0, q0, [x6, #-32]
+    cmp x2, #64
+    b.ls .Lstream_set_ret
+    stp q0, q0, [x0, #32]
+    stp q0, q0, [x6, #-64]
+    ret
+
+.Lstream_set_32:
+    cmp x2, #16
+    b.lo .Lstream_set_15
+    str q0, [x0]
+    str q0, [x6, #-16]
+    ret
+
+.Lstream_set_15:
+    cmp x2, #8
+    b.lo .Lstream_set_7
+    str d0, [x0]
+    str d0, [x6, #-8]
+    ret
+
+.Lstream_set_7:
+    cmp x2, #4
+    b.lo .Lstream_set_3
+    str s0, [x0]
+    str s0, [x6, #-4]
+    ret
+
+.Lstream_set_3:
+    cbz x2, .Lstream_set_ret
+    lsr x9, x2, #1
+    strb w1, [x0]
+    strb w1, [x0, x9]
+    strb w1, [x6, #-1]
+
+.Lstream_set_ret:
+    ret
+
+.size my_memset_stream_asm, .-my_memset_stream_asm
+
+// my_memcpy_ext_asm
+// 源与目标相对错位时的另一种做法：源按 16 字节对齐加载，相邻两个向量用 EXT 拼出
+// 目标需要的 16 字节，存储按目标对齐，加载和存储都不跨 16 字节边界，适合非对齐加载
+// 代价高的核。EXT 的移位量是立即数，因此为错位量 1~15 各生成一份循环（每份占 64 字节），
+// 按错位量计算跳转地址。源与目标相对对齐、长度小于 128 或重叠时交给 my_memcpy_asm
+
+.macro ext_loop k
+    .p2align 6
+.Lext_loop_\k:
+    ldp q17, q18, [x9, #16]
+    ldp q19, q20, [x9, #48]
+    add x9, x9, #64
+    sub x10, x10, #64
+    ext v21.16b, v16.16b, v17.16b, #\k
+    ext v22.16b, v17.16b, v18.16b, #\k
+    ext v23.16b, v18.16b, v19.16b, #\k
+    ext v24.16b, v19.16b, v20.16b, #\k
+    mov v16.16b, v20.16b
+    stp q21, q22, [x8]
+    stp q23, q24, [x8, #32]
+    add x8, x8, #64
+    cmp x10, #80            // 下一轮最多读到对齐源地址后 80 字节处
+    b.hs .Lext_loop_\k
+    b .Lext_tail
+.endm
+
+my_memcpy_ext_asm:
+    // 参数:
+    // x0 - 目标地址（返回值，不修改）
+    // x1 - 源地址
+    // x2 - 复制长度
+    sub x3, x0, x1
+    cmp x3, x2
+    b.lo .Lext_memcpy
+    cmp x2, #128
+    b.lo .Lext_memcpy
+    tst x3, #15
+    b.eq .Lext_memcpy
+
+    // 头部 32 字节和尾部 80 字节先读出，最后写入
+    add x5, x1, x2          // 源结束地址
+    add x6, x0, x2          // 目标结束地址
+    ldp q4, q5, [x1]
+    ldp q0, q1, [x5, #-80]
+    ldp q2, q3, [x5, #-48]
+    ldr q6, [x5, #-16]
+
+    // 目标从第二个 16 字节边界开始（跳过 17~32 字节），这样第一次对齐加载
+    // 的起点不早于源的开头
+    and x4, x0, #15
+    mov x7, #32
+    sub x4, x7, x4
+    add x8, x0, x4
+    add x9, x1, x4
+    sub x10, x2, x4         // 剩余长度，至少 96
+    and x7, x9, #15         // 源错位量（1~15）
+    bic x9, x9, #15         // 对齐的源地址
+    ldr q16, [x9]
+    adr x11, .Lext_loops
+    sub x7, x7, #1
+    add x11, x11, x7, lsl #6
+    br x11
+
+.Lext_tail:
+    stp q0, q1, [x6, #-80]
+    stp q2, q3, [x6, #-48]
+    str q6, [x6, #-16]
+    stp q4, q5, [x0]
     ret
 
-.size my_memset_asm, .-my_memset_asm
\ No newline at end of file
+.Lext_memcpy:
+    b my_memcpy_asm
+
+    .p2align 6
+.Lext_loops:
+    .irp k, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+    ext_loop \k
+    .endr
+
+.size my_memcpy_ext_asm, .-my_memcpy_ext_asm
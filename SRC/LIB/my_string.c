@@ -0,0 +1,292 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "my_string.h"
+
+// 页大小取最小的 4 KiB：16 字节对齐的读取不会跨页，非对齐读取前检查页内偏移
+#define STRING_PAGE_SIZE 4096
+#define VEC_SIZE 16
+
+// 有意读到字符串末尾之后（同一对齐块内），地址检查工具需要跳过这些函数
+#if defined(__SANITIZE_ADDRESS__)
+#define STRING_READS_PAST_END __attribute__((no_sanitize_address))
+#else
+#define STRING_READS_PAST_END
+#endif
+
+// ---------------------------------------------------------------------------
+// 16 字节向量的最小接口：比较结果压缩成整数掩码，每个字节占 1 << MASK_SHIFT 位，
+// 匹配的字节对应位全为 1，第 i 个字节对应最低的一组位中的第 i 组
+// ---------------------------------------------------------------------------
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+
+typedef uint8x16_t vec_t;
+#define MASK_SHIFT 2
+#define MASK_FULL (~(uint64_t)0)
+
+static inline vec_t vec_load(const unsigned char *p) { return vld1q_u8(p); }
+static inline vec_t vec_loadu(const unsigned char *p) { return vld1q_u8(p); }
+static inline vec_t vec_splat(unsigned char c) { return vdupq_n_u8(c); }
+static inline vec_t vec_eq(vec_t a, vec_t b) { return vceqq_u8(a, b); }
+static inline vec_t vec_or(vec_t a, vec_t b) { return vorrq_u8(a, b); }
+
+// NEON 没有 movemask：每个 16 位通道右移 4 位并窄化，每个字节留下 4 位
+static inline uint64_t vec_mask(vec_t m)
+{
+    uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(m), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+}
+
+#elif defined(__x86_64__)
+#include <emmintrin.h>
+
+typedef __m128i vec_t;
+#define MASK_SHIFT 0
+#define MASK_FULL ((uint64_t)0xFFFF)
+
+static inline vec_t vec_load(const unsigned char *p) { return _mm_load_si128((const __m128i *)p); }
+static inline vec_t vec_loadu(const unsigned char *p) { return _mm_loadu_si128((const __m128i *)p); }
+static inline vec_t vec_splat(unsigned char c) { return _mm_set1_epi8((char)c); }
+static inline vec_t vec_eq(vec_t a, vec_t b) { return _mm_cmpeq_epi8(a, b); }
+static inline vec_t vec_or(vec_t a, vec_t b) { return _mm_or_si128(a, b); }
+static inline uint64_t vec_mask(vec_t m) { return (uint64_t)(unsigned)_mm_movemask_epi8(m); }
+
+#else
+
+typedef struct {
+    unsigned char b[VEC_SIZE];
+} vec_t;
+#define MASK_SHIFT 0
+#define MASK_FULL ((uint64_t)0xFFFF)
+
+static inline vec_t vec_load(const unsigned char *p)
+{
+    vec_t v;
+    for (int i = 0; i < VEC_SIZE; i++) v.b[i] = p[i];
+    return v;
+}
+
+static inline vec_t vec_loadu(const unsigned char *p) { return vec_load(p); }
+
+static inline vec_t vec_splat(unsigned char c)
+{
+    vec_t v;
+    for (int i = 0; i < VEC_SIZE; i++) v.b[i] = c;
+    return v;
+}
+
+static inline vec_t vec_eq(vec_t a, vec_t b)
+{
+    vec_t v;
+    for (int i = 0; i < VEC_SIZE; i++) v.b[i] = a.b[i] == b.b[i] ? 0xFF : 0;
+    return v;
+}
+
+static inline vec_t vec_or(vec_t a, vec_t b)
+{
+    vec_t v;
+    for (int i = 0; i < VEC_SIZE; i++) v.b[i] = a.b[i] | b.b[i];
+    return v;
+}
+
+static inline uint64_t vec_mask(vec_t m)
+{
+    uint64_t mask = 0;
+    for (int i = 0; i < VEC_SIZE; i++) mask |= (uint64_t)(m.b[i] & 1) << i;
+    return mask;
+}
+
+#endif
+
+// 掩码中最低/最高一个匹配字节的序号
+static inline size_t mask_first(uint64_t m) { return (size_t)__builtin_ctzll(m) >> MASK_SHIFT; }
+static inline size_t mask_last(uint64_t m) { return (size_t)(63 - __builtin_clzll(m)) >> MASK_SHIFT; }
+
+// 只保留前 k 个字节（0 <= k <= 16）的位
+static inline uint64_t mask_keep_low(uint64_t m, size_t k)
+{
+    unsigned bits = (unsigned)k << MASK_SHIFT;
+    return bits >= 64 ? m : m & (((uint64_t)1 << bits) - 1);
+}
+
+static inline const unsigned char *align_down(const void *p)
+{
+    return (const unsigned char *)((uintptr_t)p & ~(uintptr_t)(VEC_SIZE - 1));
+}
+
+// ---------------------------------------------------------------------------
+
+STRING_READS_PAST_END
+size_t my_strlen(const char *s)
+{
+    const unsigned char *p = align_down(s);
+    unsigned off = (unsigned)((uintptr_t)s & (VEC_SIZE - 1));
+    vec_t zero = vec_splat(0);
+
+    // 第一个块去掉 s 之前的字节
+    uint64_t m = vec_mask(vec_eq(vec_load(p), zero)) >> (off << MASK_SHIFT);
+    if (m) {
+        return mask_first(m);
+    }
+    for (;;) {
+        p += VEC_SIZE;
+        m = vec_mask(vec_eq(vec_load(p), zero));
+        if (m) {
+            return (size_t)(p - (const unsigned char *)s) + mask_first(m);
+        }
+    }
+}
+
+STRING_READS_PAST_END
+void *my_memchr(const void *s, int c, size_t n)
+{
+    if (n == 0) {
+        return NULL;
+    }
+
+    const unsigned char *p = align_down(s);
+    unsigned off = (unsigned)((uintptr_t)s & (VEC_SIZE - 1));
+    vec_t needle = vec_splat((unsigned char)c);
+
+    uint64_t m = vec_mask(vec_eq(vec_load(p), needle)) >> (off << MASK_SHIFT);
+    size_t avail = VEC_SIZE - off;  // 第一个块里属于 s 的字节数
+    if (m) {
+        size_t i = mask_first(m);
+        return i < n ? (void *)((const unsigned char *)s + i) : NULL;
+    }
+    if (n <= avail) {
+        return NULL;
+    }
+    n -= avail;
+
+    // 只在还有剩余字节时读取下一个块，最后一个块至少含一个有效字节
+    for (;;) {
+        p += VEC_SIZE;
+        m = vec_mask(vec_eq(vec_load(p), needle));
+        if (m) {
+            size_t i = mask_first(m);
+            return i < n ? (void *)(p + i) : NULL;
+        }
+        if (n <= VEC_SIZE) {
+            return NULL;
+        }
+        n -= VEC_SIZE;
+    }
+}
+
+STRING_READS_PAST_END
+void *my_memrchr(const void *s, int c, size_t n)
+{
+    if (n == 0) {
+        return NULL;
+    }
+
+    const unsigned char *start = (const unsigned char *)s;
+    const unsigned char *end = start + n;
+    const unsigned char *p = align_down(end - 1);
+    vec_t needle = vec_splat((unsigned char)c);
+
+    // 从包含最后一个字节的块开始向前，去掉 end 之后和 s 之前的字节
+    uint64_t m = mask_keep_low(vec_mask(vec_eq(vec_load(p), needle)), (size_t)(end - p));
+    for (;;) {
+        if (p < start) {
+            m &= ~mask_keep_low(MASK_FULL, (size_t)(start - p));
+        }
+        if (m) {
+            return (void *)(p + mask_last(m));
+        }
+        if (p <= start) {
+            return NULL;
+        }
+        p -= VEC_SIZE;
+        m = vec_mask(vec_eq(vec_load(p), needle));
+    }
+}
+
+// 两个指针的对齐方式不同，只读 [0, n) 范围内的字节：整块用非对齐读取，
+// 不足一块的尾部与前一块重叠读取最后 16 字节
+int my_memcmp(const void *a, const void *b, size_t n)
+{
+    const unsigned char *pa = (const unsigned char *)a;
+    const unsigned char *pb = (const unsigned char *)b;
+
+    if (n < VEC_SIZE) {
+        for (size_t i = 0; i < n; i++) {
+            if (pa[i] != pb[i]) {
+                return pa[i] - pb[i];
+            }
+        }
+        return 0;
+    }
+
+    size_t i = 0;
+    for (;;) {
+        uint64_t diff = ~vec_mask(vec_eq(vec_loadu(pa + i), vec_loadu(pb + i))) & MASK_FULL;
+        if (diff) {
+            size_t k = i + mask_first(diff);
+            return pa[k] - pb[k];
+        }
+        if (i + VEC_SIZE >= n) {
+            return 0;
+        }
+        i += VEC_SIZE;
+        if (i + VEC_SIZE > n) {
+            i = n - VEC_SIZE;
+        }
+    }
+}
+
+STRING_READS_PAST_END
+char *my_strchr(const char *s, int c)
+{
+    const unsigned char *p = align_down(s);
+    unsigned off = (unsigned)((uintptr_t)s & (VEC_SIZE - 1));
+    unsigned char ch = (unsigned char)c;
+    vec_t needle = vec_splat(ch);
+    vec_t zero = vec_splat(0);
+
+    // 同时找 c 和结束符，先遇到哪个由第一个命中的字节决定
+    vec_t v = vec_load(p);
+    uint64_t m = vec_mask(vec_or(vec_eq(v, needle), vec_eq(v, zero))) >> (off << MASK_SHIFT);
+    p = (const unsigned char *)s;
+    while (!m) {
+        p = align_down(p) + VEC_SIZE;
+        v = vec_load(p);
+        m = vec_mask(vec_or(vec_eq(v, needle), vec_eq(v, zero)));
+    }
+    p += mask_first(m);
+    return *p == ch ? (char *)p : NULL;
+}
+
+// 两个字符串的对齐方式不同，用非对齐读取；任一方的下一个 16 字节会跨页时
+// 改为逐字节比较，直到越过页边界
+STRING_READS_PAST_END
+int my_strcmp(const char *a, const char *b)
+{
+    const unsigned char *pa = (const unsigned char *)a;
+    const unsigned char *pb = (const unsigned char *)b;
+    vec_t zero = vec_splat(0);
+
+    for (;;) {
+        if (((uintptr_t)pa & (STRING_PAGE_SIZE - 1)) > STRING_PAGE_SIZE - VEC_SIZE ||
+            ((uintptr_t)pb & (STRING_PAGE_SIZE - 1)) > STRING_PAGE_SIZE - VEC_SIZE) {
+            if (*pa != *pb || *pa == 0) {
+                return *pa - *pb;
+            }
+            pa++;
+            pb++;
+            continue;
+        }
+
+        vec_t va = vec_loadu(pa);
+        vec_t vb = vec_loadu(pb);
+        uint64_t stop = (~vec_mask(vec_eq(va, vb)) & MASK_FULL) | vec_mask(vec_eq(va, zero));
+        if (stop) {
+            size_t k = mask_first(stop);
+            return pa[k] - pb[k];
+        }
+        pa += VEC_SIZE;
+        pb += VEC_SIZE;
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef MY_STRING_H
+#define MY_STRING_H
+
+#include <stddef.h>
+
+// 向量化的字符串查找与比较：AArch64 上用 NEON，x86-64 主机上用 SSE2，
+// 其他平台用同样结构的逐字节实现。
+// 未知长度的字符串按 16 字节对齐的块读取，可能读到结束符之后，但不会越过所在的页；
+// 已知长度的 mem* 函数只读给定范围所在的块
+size_t my_strlen(const char *s);
+void *my_memchr(const void *s, int c, size_t n);
+void *my_memrchr(const void *s, int c, size_t n);  // 返回最后一个匹配
+int my_memcmp(const void *a, const void *b, size_t n);
+char *my_strchr(const char *s, int c);             // c 为 0 时返回结束符的位置
+int my_strcmp(const char *a, const char *b);
+
+#endif // MY_STRING_H
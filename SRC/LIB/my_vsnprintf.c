@@ -3,9 +3,47 @@
 #include <string.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include "arm_arena.h"
+#include "my_string.h"
+#include "my_vsnprintf.h"
 
 extern void serial_putc(char);
 
+// my_printf 的可选暂存后端：设置后格式化缓冲区从 arena 中分配，
+// 输出完成后回退到分配前的 mark。每个线程（裸机上每个核）各有一个，
+// 互不覆盖对方正在使用的缓冲区
+#define MY_PRINTF_SCRATCH_SIZE 1024
+
+#ifndef MY_PRINTF_MAX_CPUS
+#define MY_PRINTF_MAX_CPUS 8
+#endif
+
+#if defined(__linux__)
+static __thread arena_t *printf_scratch = NULL;
+
+static inline arena_t **printf_scratch_slot(void)
+{
+    return &printf_scratch;
+}
+#elif defined(__aarch64__)
+// 裸机：按 MPIDR_EL1.Aff0 区分核
+static arena_t *printf_scratch[MY_PRINTF_MAX_CPUS];
+
+static inline arena_t **printf_scratch_slot(void)
+{
+    uint64_t mpidr;
+    __asm__ volatile("mrs %0, mpidr_el1" : "=r"(mpidr));
+    return &printf_scratch[(mpidr & 0xff) % MY_PRINTF_MAX_CPUS];
+}
+#else
+static arena_t *printf_scratch = NULL;
+
+static inline arena_t **printf_scratch_slot(void)
+{
+    return &printf_scratch;
+}
+#endif
+
 // 辅助函数：将数字转换为指定进制的字符串
 static char *number_to_string(char *buf, unsigned long num, int base, bool is_signed, bool uppercase)
 {
@@ -39,14 +77,6 @@ static char *number_to_string(char *buf, unsigned long num, int base, bool is_si
     return ptr;
 }
 
-// 辅助函数：计算字符串长度
-static size_t string_length(const char *str)
-{
-    size_t len = 0;
-    while (*str++) len++;
-    return len;
-}
-
 // 辅助函数：复制字符串到缓冲区
 static char *string_copy(char *dest, const char *src, size_t max_len)
 {
@@ -160,9 +190,13 @@ int my_vsnprintf(char *buffer, size_t size, const char *format, va_list args)
                 const char *s = va_arg(args, const char*);
                 if (!s) s = "(null)";
                 
-                size_t len = string_length(s);
-                if (precision >= 0 && (size_t)precision < len) {
-                    len = precision;
+                // 有精度时只在前 precision 个字节内找结束符，不要求 s 以 '\0' 结尾
+                size_t len;
+                if (precision >= 0) {
+                    const char *end = my_memchr(s, '\0', (size_t)precision);
+                    len = end ? (size_t)(end - s) : (size_t)precision;
+                } else {
+                    len = my_strlen(s);
                 }
                 
                 // 处理宽度和对齐
@@ -194,13 +228,14 @@ int my_vsnprintf(char *buffer, size_t size, const char *format, va_list args)
                 // 有符号十进制整数
                 int num = va_arg(args, int);
                 char *num_str = number_to_string(num_buf, (unsigned long)(num < 0 ? -num : num), 10, true, false);
+                size_t num_len = (size_t)(num_str - num_buf);
                 
                 // 处理符号
                 bool negative = num < 0;
                 bool has_sign = negative || always_sign || space_sign;
                 char sign_char = negative ? '-' : (always_sign ? '+' : (space_sign ? ' ' : '\0'));
                 
-                size_t len = string_length(num_buf);
+                size_t len = num_len;
                 
                 // 处理精度
                 if (precision > (int)len) {
@@ -226,8 +261,8 @@ int my_vsnprintf(char *buffer, size_t size, const char *format, va_list args)
                 }
                 
                 // 输出前导零（精度指定的）
-                if (precision > (int)string_length(num_buf)) {
-                    for (int i = 0; i < precision - (int)string_length(num_buf) && written < (int)size - 1; i++) {
+                if (precision > (int)num_len) {
+                    for (int i = 0; i < precision - (int)num_len && written < (int)size - 1; i++) {
                         *ptr++ = '0';
                         written++;
                     }
@@ -254,7 +289,8 @@ int my_vsnprintf(char *buffer, size_t size, const char *format, va_list args)
                 // 无符号十进制整数
                 unsigned int num = va_arg(args, unsigned int);
                 char *num_str = number_to_string(num_buf, num, 10, false, false);
-                size_t len = string_length(num_buf);
+                size_t num_len = (size_t)(num_str - num_buf);
+                size_t len = num_len;
                 
                 // 处理精度
                 if (precision > (int)len) {
@@ -271,8 +307,8 @@ int my_vsnprintf(char *buffer, size_t size, const char *format, va_list args)
                 }
                 
                 // 输出前导零（精度指定的）
-                if (precision > (int)string_length(num_buf)) {
-                    for (int i = 0; i < precision - (int)string_length(num_buf) && written < (int)size - 1; i++) {
+                if (precision > (int)num_len) {
+                    for (int i = 0; i < precision - (int)num_len && written < (int)size - 1; i++) {
                         *ptr++ = '0';
                         written++;
                     }
@@ -300,7 +336,8 @@ int my_vsnprintf(char *buffer, size_t size, const char *format, va_list args)
                 unsigned int num = va_arg(args, unsigned int);
                 bool upper = (*fmt == 'X');
                 char *num_str = number_to_string(num_buf, num, 16, false, upper);
-                size_t len = string_length(num_buf);
+                size_t num_len = (size_t)(num_str - num_buf);
+                size_t len = num_len;
                 
                 // 处理替代形式
                 if (alternate_form && num != 0) {
@@ -308,8 +345,8 @@ int my_vsnprintf(char *buffer, size_t size, const char *format, va_list args)
                 }
                 
                 // 处理精度
-                if (precision > (int)string_length(num_buf)) {
-                    len += precision - string_length(num_buf);
+                if (precision > (int)num_len) {
+                    len += precision - num_len;
                 }
                 
                 // 处理宽度和对齐
@@ -332,8 +369,8 @@ int my_vsnprintf(char *buffer, size_t size, const char *format, va_list args)
                 }
                 
                 // 输出前导零（精度指定的）
-                if (precision > (int)string_length(num_buf)) {
-                    for (int i = 0; i < precision - (int)string_length(num_buf) && written < (int)size - 1; i++) {
+                if (precision > (int)num_len) {
+                    for (int i = 0; i < precision - (int)num_len && written < (int)size - 1; i++) {
                         *ptr++ = '0';
                         written++;
                     }
@@ -360,7 +397,8 @@ int my_vsnprintf(char *buffer, size_t size, const char *format, va_list args)
                 // 指针
                 void *p = va_arg(args, void*);
                 char *num_str = number_to_string(num_buf, (unsigned long)p, 16, false, false);
-                size_t len = string_length(num_buf) + 2; // "0x" 前缀
+                size_t num_len = (size_t)(num_str - num_buf);
+                size_t len = num_len + 2; // "0x" 前缀
                 
                 // 处理宽度和对齐
                 if (!left_align && width > (int)len) {
@@ -381,8 +419,8 @@ int my_vsnprintf(char *buffer, size_t size, const char *format, va_list args)
                 }
                 
                 // 输出前导零
-                if (string_length(num_buf) < sizeof(void*) * 2) {
-                    for (size_t i = 0; i < sizeof(void*) * 2 - string_length(num_buf) && written < (int)size - 1; i++) {
+                if (num_len < sizeof(void*) * 2) {
+                    for (size_t i = 0; i < sizeof(void*) * 2 - num_len && written < (int)size - 1; i++) {
                         *ptr++ = '0';
                         written++;
                     }
@@ -451,20 +489,37 @@ int my_snprintf(char *buffer, size_t size, const char *format, ...)
     return result;
 }
 
+void my_printf_set_scratch(arena_t *arena)
+{
+    *printf_scratch_slot() = arena;
+}
+
 int my_printf(const char *format, ...)
 {
     va_list args;
     int length;
-    char buffer[256]; // 可根据需要调整大小
+    char stack_buffer[256]; // 可根据需要调整大小
+    char *buffer = stack_buffer;
+    size_t size = sizeof(stack_buffer);
+    arena_t *scratch = *printf_scratch_slot();
+    arena_mark_t mark = arena_mark(scratch);
+    
+    if (scratch != NULL) {
+        char *scratch_buffer = (char *)arena_alloc(scratch, MY_PRINTF_SCRATCH_SIZE);
+        if (scratch_buffer != NULL) {
+            buffer = scratch_buffer;
+            size = MY_PRINTF_SCRATCH_SIZE;
+        }
+    }
     
     va_start(args, format);
     // 使用 vsnprintf 避免缓冲区溢出
-    length = my_vsnprintf(buffer, sizeof(buffer), format, args);
+    length = my_vsnprintf(buffer, size, format, args);
     va_end(args);
     
     // 如果格式化后的字符串超过缓冲区大小，则截断
-    if (length >= (int)sizeof(buffer)) {
-        length = sizeof(buffer) - 1;
+    if (length >= (int)size) {
+        length = size - 1;
         buffer[length] = '\0';
     }
     
@@ -476,6 +531,7 @@ int my_printf(const char *format, ...)
         serial_putc(buffer[i]);
     }
     
+    arena_reset_to_mark(scratch, mark);
     return length;
 }
 
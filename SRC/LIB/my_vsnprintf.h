@@ -0,0 +1,21 @@
+#ifndef MY_VSNPRINTF_H
+#define MY_VSNPRINTF_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include "arm_arena.h"
+
+// 精简版格式化输出，my_printf 经 serial_putc 输出（'\n' 前补 '\r'）
+int my_vsnprintf(char *buffer, size_t size, const char *format, va_list args);
+int my_snprintf(char *buffer, size_t size, const char *format, ...);
+int my_printf(const char *format, ...);
+int my_putchar(int c);
+int my_puts(const char *str);
+
+// 设置当前线程（裸机上为当前核）的 my_printf 暂存 arena，NULL 恢复使用栈缓冲区；
+// 未设置的线程和核始终使用栈缓冲区。每次调用结束时回退到调用前的 mark，
+// arena 在被替换或清除之前必须一直有效。
+// 不同线程/核不得设置同一个 arena；设置了 arena 的核上，中断处理程序不得调用 my_printf
+void my_printf_set_scratch(arena_t *arena);
+
+#endif // MY_VSNPRINTF_H
@@ -4,6 +4,7 @@
 #include <math.h>
 #include <stddef.h>
 #include <stdio.h>
+#include "my_string.h"
 
 extern int serial_getc(void);
 extern void serial_putc(char);
@@ -172,14 +173,8 @@ static bool read_string(const char **input, char *str, int width, const char *de
     while (**input && !isspace((unsigned char)**input) && 
            (width < 0 || count < width)) {
         // 检查是否遇到分隔符
-        if (delimiters) {
-            const char *d = delimiters;
-            while (*d) {
-                if (**input == *d) {
-                    goto done;
-                }
-                d++;
-            }
+        if (delimiters && my_strchr(delimiters, **input)) {
+            goto done;
         }
         
         *str++ = **input;
@@ -232,17 +227,8 @@ static bool read_scanset(const char **input, char *str, int width, const char *s
     
     // 读取字符直到遇到不在集合中的字符或达到宽度限制
     while (**input && (width < 0 || count < width)) {
-        bool in_set = false;
-        const char *s = scanset;
-        
-        // 检查字符是否在集合中
-        while (*s) {
-            if (**input == *s) {
-                in_set = true;
-                break;
-            }
-            s++;
-        }
+        // 检查字符是否在集合中（**input 不为 0，不会匹配到集合的结束符）
+        bool in_set = my_strchr(scanset, **input) != NULL;
         
         // 根据是否反转决定是否接受字符
         if ((in_set && !invert) || (!in_set && invert)) {
@@ -0,0 +1,111 @@
+// my_memmove 系列正确性测试：变体表中的每个实现以及内联入口 pbs_memmove，
+// 与逐字节的参考实现逐一比较。覆盖 0~300 字节和若干大尺寸、
+// 目标相对源 -64~+64 的全部重叠偏移、多种源地址对齐，并检查访问范围之外的字节未被改写
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "my_memory.h"
+
+#define SMALL_MAX   300
+#define MAX_DELTA   64
+#define GUARD       32
+#define MAX_LEN     65543
+#define BUF_SIZE    (MAX_LEN + 2 * MAX_DELTA + 2 * GUARD + 64)
+#define MAX_REPORTS 10
+
+static const size_t large_sizes[] = { 511, 1000, 4099, 65543 };
+static const size_t src_aligns[] = { 0, 1, 3, 8, 15 };
+
+static unsigned char buf[BUF_SIZE] __attribute__((aligned(64)));
+static unsigned char ref[BUF_SIZE] __attribute__((aligned(64)));
+
+// 参考实现：目标在源之前时从前往后逐字节复制，否则从后往前
+static void ref_memmove(unsigned char *dst, const unsigned char *src, size_t n) {
+    if (dst < src) {
+        for (size_t i = 0; i < n; i++) {
+            dst[i] = src[i];
+        }
+    } else {
+        for (size_t i = n; i > 0; i--) {
+            dst[i - 1] = src[i - 1];
+        }
+    }
+}
+
+// 内联入口不在变体表中，包一层以便同样遍历
+static void *inline_memmove(void *dest, const void *src, size_t n) {
+    return pbs_memmove(dest, src, n);
+}
+
+static long failures;
+static unsigned pattern_seed;
+
+// 测一个 (实现, 长度, 对齐, 偏移) 组合：只填充并比较本次涉及的窗口
+static void check(const char *name, pbs_copy_fn fn, size_t n, size_t align, int delta) {
+    size_t src_off = GUARD + MAX_DELTA + align;
+    size_t dst_off = (size_t)((long)src_off + delta);
+    size_t lo = (src_off < dst_off ? src_off : dst_off) - GUARD;
+    size_t hi = (src_off > dst_off ? src_off : dst_off) + n + GUARD;
+
+    pattern_seed = pattern_seed * 1664525u + 1013904223u;
+    unsigned char seed = (unsigned char)(pattern_seed >> 24);
+    for (size_t i = lo; i < hi; i++) {
+        buf[i] = (unsigned char)(i * 131 + seed);
+    }
+    memcpy(ref + lo, buf + lo, hi - lo);
+
+    ref_memmove(ref + dst_off, ref + src_off, n);
+    void *ret = fn(buf + dst_off, buf + src_off, n);
+
+    if (ret != buf + dst_off || memcmp(buf + lo, ref + lo, hi - lo) != 0) {
+        if (failures < MAX_REPORTS) {
+            size_t first = lo;
+            while (first < hi && buf[first] == ref[first]) {
+                first++;
+            }
+            printf("FAIL %-8s n=%zu align=%zu delta=%d%s first_diff=%ld\n", name, n, align, delta,
+                   ret != buf + dst_off ? " (返回值错误)" : "",
+                   first < hi ? (long)first - (long)dst_off : -1L);
+        }
+        failures++;
+    }
+}
+
+static long run_variant(const char *name, pbs_copy_fn fn) {
+    long cases = 0;
+    long before = failures;
+    for (size_t a = 0; a < sizeof(src_aligns) / sizeof(src_aligns[0]); a++) {
+        for (int delta = -MAX_DELTA; delta <= MAX_DELTA; delta++) {
+            for (size_t n = 0; n <= SMALL_MAX; n++) {
+                check(name, fn, n, src_aligns[a], delta);
+                cases++;
+            }
+            for (size_t i = 0; i < sizeof(large_sizes) / sizeof(large_sizes[0]); i++) {
+                check(name, fn, large_sizes[i], src_aligns[a], delta);
+                cases++;
+            }
+        }
+    }
+    printf("%-10s %8ld 项  %s\n", name, cases, failures == before ? "通过" : "失败");
+    return cases;
+}
+
+int main(void) {
+    unsigned features = pbs_cpu_features();
+
+    for (size_t i = 0; i < pbs_memmove_variant_count; i++) {
+        const pbs_copy_variant *v = &pbs_memmove_variants[i];
+        if ((v->requires & features) != v->requires) {
+            printf("%-10s 跳过（CPU 不支持）\n", v->name);
+            continue;
+        }
+        run_variant(v->name, v->fn);
+    }
+    run_variant("inline", inline_memmove);
+
+    if (failures != 0) {
+        printf("共 %ld 项失败\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+// 分桶引擎回归测试：最后一个桶（大于 4 MiB 的块都在其中）的链表头部有超过
+// BUCKET_SCAN_LIMIT 个放不下请求的空闲块，唯一足够大的块在链表尾部，
+// 没有更高的桶可跳，分配仍须找到尾部的块而不是报告内存不足
+#include <stdio.h>
+#include <stdlib.h>
+#include "arm_malloc.h"
+
+#define MIB         ((size_t)1 << 20)
+#define REGION_SIZE (64 * MIB)
+#define SMALL_COUNT 12
+#define SMALL_SIZE  (4 * MIB + 256 * 1024)  // 落在最后一个桶，但小于请求
+#define FIT_SIZE    (6 * MIB)
+#define REQUEST     (5 * MIB + 512 * 1024)
+#define SEP_SIZE    1024                    // 隔开各块，防止释放后合并
+
+int main(void) {
+    void *region = malloc(REGION_SIZE);
+    if (region == NULL) {
+        printf("无法申请测试区域\n");
+        return 1;
+    }
+
+    heap_t *h = heap_create(region, REGION_SIZE, ARM_MALLOC_SEGREGATED);
+    if (h == NULL) {
+        printf("heap_create 失败\n");
+        return 1;
+    }
+
+    void *fit = heap_malloc(h, FIT_SIZE);
+    heap_malloc(h, SEP_SIZE);
+    void *small[SMALL_COUNT];
+    for (int i = 0; i < SMALL_COUNT; i++) {
+        small[i] = heap_malloc(h, SMALL_SIZE);
+        heap_malloc(h, SEP_SIZE);
+    }
+    if (fit == NULL || small[SMALL_COUNT - 1] == NULL) {
+        printf("布置堆失败\n");
+        return 1;
+    }
+
+    // 占满剩余空间，之后只剩上面释放的块可用
+    for (size_t size = 8 * MIB; size >= SEP_SIZE; size /= 2) {
+        while (heap_malloc(h, size) != NULL) {
+        }
+    }
+
+    // 插入在链表头部：先放入的 fit 最终位于尾部
+    heap_free(fit);
+    heap_maintenance(h);
+    for (int i = 0; i < SMALL_COUNT; i++) {
+        heap_free(small[i]);
+    }
+    heap_maintenance(h);
+
+    void *p = heap_malloc(h, REQUEST);
+    if (p != fit) {
+        printf("FAIL 最后一个桶尾部的块未被找到：返回 %p，期望 %p\n", p, fit);
+        return 1;
+    }
+    printf("segregated 最后一个桶长链  通过\n");
+
+    heap_destroy(h);
+    free(region);
+    return 0;
+}